@@ -0,0 +1,74 @@
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <iterator>
+#include <random>
+#include <sstream>
+#include <string>
+
+#include "benchmark/benchmark.h"
+#include "io/matrix_io.hh"
+#include "io/text_parser.hh"
+#include "matrix/matrix.hh"
+
+namespace {
+
+/** Driver input of n x n matrix with elements like in e2e tests */
+std::string matrixText(std::size_t n) {
+  std::mt19937 gen(42);
+  std::uniform_real_distribution<double> dist(0.8, 1.25);
+  auto text = std::to_string(n) + "\n";
+  char buf[32];
+  for (std::size_t i = 0; i < n * n; ++i) {
+    auto len = std::snprintf(buf, sizeof(buf), "%f ", dist(gen));
+    text.append(buf, len);
+  }
+  return text;
+}
+
+void BM_TextParser(benchmark::State& state) {
+  auto text = matrixText(static_cast<std::size_t>(state.range(0)));
+  for (auto _ : state) {
+    io::TextParser parser(text);
+    auto m = io::readSquareMatrix<double>(parser);
+    benchmark::DoNotOptimize(m.data());
+  }
+  state.SetBytesProcessed(
+      static_cast<std::int64_t>(state.iterations() * text.size()));
+}
+
+/** Chunked parsing on pool of given number of threads */
+void BM_TextParserParallel(benchmark::State& state) {
+  auto text = matrixText(static_cast<std::size_t>(state.range(0)));
+  matrix::ThreadPool pool(static_cast<std::size_t>(state.range(1)));
+  for (auto _ : state) {
+    io::TextParser parser(text);
+    auto m = io::readSquareMatrix<double>(parser, pool);
+    benchmark::DoNotOptimize(m.data());
+  }
+  state.SetBytesProcessed(
+      static_cast<std::int64_t>(state.iterations() * text.size()));
+}
+
+/** Previous driver input path, kept as a baseline */
+void BM_IstreamIterator(benchmark::State& state) {
+  auto text = matrixText(static_cast<std::size_t>(state.range(0)));
+  for (auto _ : state) {
+    std::istringstream is(text);
+    std::size_t n;
+    is >> n;
+    matrix::Matrix<double> m(n, n, std::istream_iterator<double>(is));
+    benchmark::DoNotOptimize(m.data());
+  }
+  state.SetBytesProcessed(
+      static_cast<std::int64_t>(state.iterations() * text.size()));
+}
+
+}  // namespace
+
+BENCHMARK(BM_TextParser)->RangeMultiplier(4)->Range(16, 1024);
+BENCHMARK(BM_TextParserParallel)
+    ->ArgsProduct({{1024, 4096}, {1, 2, 4, 8}})
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+BENCHMARK(BM_IstreamIterator)->RangeMultiplier(4)->Range(16, 1024);
@@ -0,0 +1,175 @@
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <random>
+
+#include "benchmark/benchmark.h"
+#include "matrix/matrix.hh"
+
+namespace {
+
+matrix::Matrix<double> randomMatrix(std::size_t n) {
+  std::mt19937 gen(42);
+  std::uniform_real_distribution<double> dist(-1.0, 1.0);
+  matrix::Matrix<double> m(n, n);
+  std::generate(m.begin(), m.end(), [&] { return dist(gen); });
+  return m;
+}
+
+void setFlops(benchmark::State& state, double flops_per_iteration) {
+  state.counters["FLOPS"] = benchmark::Counter(
+      flops_per_iteration, benchmark::Counter::kIsIterationInvariantRate);
+}
+
+void setBytes(benchmark::State& state, std::size_t bytes_per_iteration) {
+  state.SetBytesProcessed(static_cast<std::int64_t>(state.iterations() *
+                                                    bytes_per_iteration));
+}
+
+void BM_Det(benchmark::State& state) {
+  auto n = static_cast<std::size_t>(state.range(0));
+  auto m = randomMatrix(n);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(m.det());
+  }
+  setFlops(state, 2.0 / 3 * n * n * n);
+  setBytes(state, n * n * sizeof(double));
+}
+
+void BM_DetParallel(benchmark::State& state) {
+  auto n = static_cast<std::size_t>(state.range(0));
+  auto m = randomMatrix(n);
+  matrix::LuOptions opts;
+  opts.pool = &matrix::ThreadPool::global();
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(m.det(opts));
+  }
+  setFlops(state, 2.0 / 3 * n * n * n);
+  setBytes(state, n * n * sizeof(double));
+}
+
+void BM_DetRecursive(benchmark::State& state) {
+  auto n = static_cast<std::size_t>(state.range(0));
+  auto m = randomMatrix(n);
+  matrix::LuOptions opts;
+  opts.algorithm = matrix::LuAlgorithm::kRecursive;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(m.det(opts));
+  }
+  setFlops(state, 2.0 / 3 * n * n * n);
+  setBytes(state, n * n * sizeof(double));
+}
+
+/** Band matrix with 8 sub- and superdiagonals takes band LU */
+void BM_DetBanded(benchmark::State& state) {
+  constexpr std::size_t kBand = 8;
+  auto n = static_cast<std::size_t>(state.range(0));
+  auto m = randomMatrix(n);
+  for (std::size_t i = 0; i < n; ++i) {
+    for (std::size_t j = 0; j < n; ++j) {
+      if (i > j + kBand || j > i + kBand) {
+        m[i][j] = 0;
+      }
+    }
+  }
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(m.det());
+  }
+  setFlops(state, 2.0 * n * kBand * (2 * kBand + 1));
+}
+
+void BM_Product(benchmark::State& state) {
+  auto n = static_cast<std::size_t>(state.range(0));
+  auto a = randomMatrix(n);
+  auto b = randomMatrix(n);
+  for (auto _ : state) {
+    auto c = a * b;
+    benchmark::DoNotOptimize(c.data());
+  }
+  setFlops(state, 2.0 * n * n * n);
+}
+
+/** Elimination of the first column below the diagonal */
+void BM_SimplifyRows(benchmark::State& state) {
+  auto n = static_cast<std::size_t>(state.range(0));
+  auto m = randomMatrix(n);
+  for (auto _ : state) {
+    m.simplifyRows(0);
+    benchmark::DoNotOptimize(m.data());
+    benchmark::ClobberMemory();
+  }
+  setFlops(state, 2.0 * (n - 1) * n);
+  setBytes(state, 2 * (n - 1) * n * sizeof(double));
+}
+
+/**
+ * Pivoted elimination of n x 64 panel, the column-by-column part of
+ * blocked LU, with padded rows as in det(). Panel is restored from a
+ * copy before every iteration.
+ */
+void BM_LuPanel(benchmark::State& state) {
+  constexpr std::size_t kWidth = matrix::detail::kDefaultLuBlockSize;
+  auto n = static_cast<std::size_t>(state.range(0));
+  auto ld = matrix::detail::paddedStride<double>(n);
+  auto m = randomMatrix(n);
+  vector::Vector<double> work(n * ld);
+  vector::Vector<std::size_t> piv(n);
+  for (auto _ : state) {
+    state.PauseTiming();
+    for (std::size_t i = 0; i < n; ++i) {
+      std::copy_n(m.cbegin() + i * n, n, work.begin() + i * ld);
+    }
+    state.ResumeTiming();
+    matrix::detail::luPanel(work.data(), n, ld, 0, kWidth, piv.data());
+    benchmark::ClobberMemory();
+  }
+  setFlops(state, 1.0 * n * kWidth * kWidth);
+  setBytes(state, n * kWidth * sizeof(double));
+}
+
+void BM_SwapRows(benchmark::State& state) {
+  auto n = static_cast<std::size_t>(state.range(0));
+  auto m = randomMatrix(n);
+  for (auto _ : state) {
+    m.swapRows(0, n - 1);
+    benchmark::ClobberMemory();
+  }
+  setBytes(state, 2 * n * sizeof(double));
+}
+
+/** Row-major to tiled and back, blocked copies on both sides */
+void BM_LayoutConvert(benchmark::State& state) {
+  auto n = static_cast<std::size_t>(state.range(0));
+  auto m = randomMatrix(n);
+  for (auto _ : state) {
+    matrix::Matrix<double, matrix::TileMajor<>> tile(m);
+    matrix::Matrix<double, matrix::ColMajor> col(tile);
+    benchmark::DoNotOptimize(col.data());
+  }
+  setBytes(state, 4 * n * n * sizeof(double));
+}
+
+}  // namespace
+
+BENCHMARK(BM_Det)->RangeMultiplier(2)->Range(4, 4096)->Unit(
+    benchmark::kMicrosecond);
+BENCHMARK(BM_DetParallel)
+    ->RangeMultiplier(2)
+    ->Range(256, 4096)
+    ->Unit(benchmark::kMicrosecond)
+    ->UseRealTime();
+BENCHMARK(BM_DetRecursive)->RangeMultiplier(2)->Range(4, 4096)->Unit(
+    benchmark::kMicrosecond);
+BENCHMARK(BM_DetBanded)->RangeMultiplier(4)->Range(64, 4096)->Unit(
+    benchmark::kMicrosecond);
+BENCHMARK(BM_Product)
+    ->RangeMultiplier(2)
+    ->Range(16, 2048)
+    ->Unit(benchmark::kMicrosecond)
+    ->UseRealTime();
+BENCHMARK(BM_SimplifyRows)->RangeMultiplier(4)->Range(16, 4096);
+BENCHMARK(BM_SwapRows)->RangeMultiplier(4)->Range(16, 4096);
+BENCHMARK(BM_LuPanel)->RangeMultiplier(4)->Range(256, 4096)->Unit(
+    benchmark::kMicrosecond);
+BENCHMARK(BM_LayoutConvert)->RangeMultiplier(4)->Range(64, 4096)->Unit(
+    benchmark::kMicrosecond);
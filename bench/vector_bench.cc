@@ -0,0 +1,91 @@
+#include <cstddef>
+#include <cstdint>
+
+#include "benchmark/benchmark.h"
+#include "vector/vector.hh"
+
+namespace {
+
+constexpr std::int64_t kMinSize = 1 << 6;
+constexpr std::int64_t kMaxSize = 1 << 22;
+
+void setBytes(benchmark::State& state, std::size_t bytes_per_iteration) {
+  state.SetBytesProcessed(static_cast<std::int64_t>(state.iterations() *
+                                                    bytes_per_iteration));
+}
+
+void BM_VectorSizeCtor(benchmark::State& state) {
+  auto n = static_cast<std::size_t>(state.range(0));
+  for (auto _ : state) {
+    vector::Vector<double> v(n, 1.0);
+    benchmark::DoNotOptimize(v.data());
+  }
+  setBytes(state, n * sizeof(double));
+}
+
+void BM_VectorCopy(benchmark::State& state) {
+  auto n = static_cast<std::size_t>(state.range(0));
+  vector::Vector<double> src(n, 1.0);
+  for (auto _ : state) {
+    vector::Vector<double> v(src);
+    benchmark::DoNotOptimize(v.data());
+  }
+  setBytes(state, n * sizeof(double));
+}
+
+void BM_VectorPushBack(benchmark::State& state) {
+  auto n = static_cast<std::size_t>(state.range(0));
+  for (auto _ : state) {
+    vector::Vector<double> v;
+    for (std::size_t i = 0; i < n; ++i) {
+      v.push_back(static_cast<double>(i));
+    }
+    benchmark::DoNotOptimize(v.data());
+  }
+  setBytes(state, n * sizeof(double));
+}
+
+void BM_VectorReservePushBack(benchmark::State& state) {
+  auto n = static_cast<std::size_t>(state.range(0));
+  for (auto _ : state) {
+    vector::Vector<double> v;
+    v.reserve(n);
+    for (std::size_t i = 0; i < n; ++i) {
+      v.push_back(static_cast<double>(i));
+    }
+    benchmark::DoNotOptimize(v.data());
+  }
+  setBytes(state, n * sizeof(double));
+}
+
+/** Reallocation of filled vector: relocates existing elements */
+void BM_VectorReserve(benchmark::State& state) {
+  auto n = static_cast<std::size_t>(state.range(0));
+  for (auto _ : state) {
+    state.PauseTiming();
+    vector::Vector<double> v(n, 1.0);
+    state.ResumeTiming();
+    v.reserve(2 * n);
+    benchmark::DoNotOptimize(v.data());
+  }
+  setBytes(state, n * sizeof(double));
+}
+
+void BM_VectorResize(benchmark::State& state) {
+  auto n = static_cast<std::size_t>(state.range(0));
+  for (auto _ : state) {
+    vector::Vector<double> v;
+    v.resize(n);
+    benchmark::DoNotOptimize(v.data());
+  }
+  setBytes(state, n * sizeof(double));
+}
+
+}  // namespace
+
+BENCHMARK(BM_VectorSizeCtor)->Range(kMinSize, kMaxSize);
+BENCHMARK(BM_VectorCopy)->Range(kMinSize, kMaxSize);
+BENCHMARK(BM_VectorPushBack)->Range(kMinSize, kMaxSize);
+BENCHMARK(BM_VectorReservePushBack)->Range(kMinSize, kMaxSize);
+BENCHMARK(BM_VectorReserve)->Range(kMinSize, kMaxSize);
+BENCHMARK(BM_VectorResize)->Range(kMinSize, kMaxSize);
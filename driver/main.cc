@@ -1,15 +1,369 @@
+#include <unistd.h>
+
+#include <chrono>
+#include <cstdio>
 #include <cstdlib>
+#include <cstdint>
+#include <deque>
+#include <fstream>
+#include <future>
+#include <iomanip>
 #include <iostream>
-#include <iterator>
+#include <ostream>
+#include <stdexcept>
+#include <string>
 
+#include "io/binary_format.hh"
+#include "io/input_buffer.hh"
+#include "io/matrix_io.hh"
+#include "io/out_of_core.hh"
 #include "matrix/matrix.hh"
+#include "matrix/matrix_view.hh"
+#include "matrix/sparse_matrix.hh"
+#include "vector/stats.hh"
+
+namespace {
+
+const char* const kUsage =
+    "Usage: driver [--format text|binary|coo] [--write-binary out] "
+    "[--batch] [--exact] [--out-of-core scratch] [--memory-budget MiB] "
+    "[--stats] [--stats-json] [file]\n"
+    "Computes determinant of matrix read from file or stdin.\n"
+    "  --format text      n followed by n * n elements (default)\n"
+    "  --format binary    binary format, see io/binary_format.hh\n"
+    "  --format coo       sparse matrix: n and nnz followed by nnz triples\n"
+    "                     \"row col value\" with 0-based indices\n"
+    "  --write-binary out convert input to binary format instead\n"
+    "  --batch            read text records until end of input and print\n"
+    "                     determinant of each one on its own line\n"
+    "  --exact            read integer text matrix and print its exact\n"
+    "                     determinant\n"
+    "  --out-of-core scratch\n"
+    "                     convert text or binary input into panel file\n"
+    "                     scratch and factorize it there, for matrices\n"
+    "                     larger than memory; scratch is removed after\n"
+    "  --memory-budget MiB\n"
+    "                     memory for panels of --out-of-core, default 1024\n"
+    "  --stats            print time of phases, allocations and GFLOP/s\n"
+    "                     to stderr, requires build with ENABLE_STATS\n"
+    "  --stats-json       same in JSON\n";
+
+enum class Format { kText, kBinary, kCoo };
+
+enum class Stats { kNone, kText, kJson };
+
+struct Options {
+  Format format = Format::kText;
+  Stats stats = Stats::kNone;
+  bool batch = false;
+  bool exact = false;
+  std::string input;
+  std::string write_binary;
+  std::string out_of_core;
+  std::size_t memory_budget_mib = 1024;
+};
+
+Options parseOptions(int argc, char** argv) {
+  Options opts;
+  for (int i = 1; i < argc; ++i) {
+    auto arg = std::string(argv[i]);
+    auto value = [&] {
+      if (i + 1 == argc) {
+        throw std::runtime_error("missing value of " + arg + "\n" + kUsage);
+      }
+      return std::string(argv[++i]);
+    };
+
+    if (arg == "--format") {
+      auto fmt = value();
+      if (fmt == "text") {
+        opts.format = Format::kText;
+      } else if (fmt == "binary") {
+        opts.format = Format::kBinary;
+      } else if (fmt == "coo") {
+        opts.format = Format::kCoo;
+      } else {
+        throw std::runtime_error("unknown format " + fmt + "\n" + kUsage);
+      }
+    } else if (arg == "--write-binary") {
+      opts.write_binary = value();
+    } else if (arg == "--out-of-core") {
+      opts.out_of_core = value();
+    } else if (arg == "--memory-budget") {
+      auto mib = value();
+      std::size_t pos = 0;
+      opts.memory_budget_mib = std::stoul(mib, &pos);
+      if (pos != mib.size() || !opts.memory_budget_mib) {
+        throw std::runtime_error("invalid memory budget " + mib);
+      }
+    } else if (arg == "--batch") {
+      opts.batch = true;
+    } else if (arg == "--exact") {
+      opts.exact = true;
+    } else if (arg == "--stats") {
+      opts.stats = Stats::kText;
+    } else if (arg == "--stats-json") {
+      opts.stats = Stats::kJson;
+    } else if (arg == "-h" || arg == "--help") {
+      std::cout << kUsage;
+      std::exit(EXIT_SUCCESS);
+    } else if (opts.input.empty() && arg[0] != '-') {
+      opts.input = arg;
+    } else {
+      throw std::runtime_error("unexpected argument " + arg + "\n" + kUsage);
+    }
+  }
+  return opts;
+}
+
+io::InputBuffer openInput(const Options& opts) {
+  vector::stats::ScopedPhase phase(vector::stats::Phase::kParse);
+  return opts.input.empty() ? io::InputBuffer::fromFd(STDIN_FILENO)
+                            : io::InputBuffer::fromFile(opts.input);
+}
+
+/** Computes over mapped elements without copying them out of the file */
+double binaryDet(const io::MappedMatrix& mm, const matrix::LuOptions& opts) {
+  switch (mm.elemType()) {
+    case io::ElemType::kFloat32:
+      return mm.view<float>().det(opts);
+    case io::ElemType::kFloat64:
+      return mm.view<double>().det(opts);
+    case io::ElemType::kInt32:
+      return mm.view<std::int32_t>().det(opts);
+    case io::ElemType::kInt64:
+      return mm.view<std::int64_t>().det(opts);
+  }
+  throw std::runtime_error("unknown element type");
+}
+
+/** Writes elements of mapped matrix into panel file */
+io::PanelFile binaryPanels(const io::MappedMatrix& mm, const std::string& path,
+                           std::size_t budget) {
+  switch (mm.elemType()) {
+    case io::ElemType::kFloat32:
+      return io::writePanels(mm.view<float>(), path, budget);
+    case io::ElemType::kFloat64:
+      return io::writePanels(mm.view<double>(), path, budget);
+    case io::ElemType::kInt32:
+      return io::writePanels(mm.view<std::int32_t>(), path, budget);
+    case io::ElemType::kInt64:
+      return io::writePanels(mm.view<std::int64_t>(), path, budget);
+  }
+  throw std::runtime_error("unknown element type");
+}
+
+/**
+ * Converts input into panel file at scratch path and factorizes it there,
+ * so that only memory budget is held in memory. Binary input is mapped,
+ * text one is streamed. Scratch file is removed afterwards.
+ */
+double outOfCoreDet(const Options& opts, matrix::ThreadPool& pool) {
+  using vector::stats::Phase;
+  auto budget = opts.memory_budget_mib << 20;
+  const auto& path = opts.out_of_core;
+  auto convert = [&] {
+    if (opts.format == Format::kBinary) {
+      io::MappedMatrix mm(openInput(opts));
+      vector::stats::ScopedPhase phase(Phase::kConvert);
+      return binaryPanels(mm, path, budget);
+    }
+
+    vector::stats::ScopedPhase phase(Phase::kParse);
+    if (opts.input.empty()) {
+      io::TextParser parser(STDIN_FILENO);
+      return io::writePanels(parser, path, budget);
+    }
+    auto input = io::InputBuffer::fromFile(opts.input);
+    io::TextParser parser(input.view());
+    return io::writePanels(parser, path, budget);
+  };
+
+  try {
+    auto file = convert();
+    auto det = io::outOfCoreDet(file, &pool);
+    std::remove(path.c_str());
+    return det;
+  } catch (...) {
+    std::remove(path.c_str());
+    throw;
+  }
+}
+
+/** Parses in parallel on pool if it is given */
+template <typename T>
+matrix::Matrix<T> readText(io::TextParser& parser,
+                           matrix::ThreadPool* pool = nullptr) {
+  vector::stats::ScopedPhase phase(vector::stats::Phase::kParse);
+  return pool ? io::readSquareMatrix<T>(parser, *pool)
+              : io::readSquareMatrix<T>(parser);
+}
+
+template <typename T>
+matrix::SparseMatrix<T> readCoo(io::TextParser& parser) {
+  vector::stats::ScopedPhase phase(vector::stats::Phase::kParse);
+  return io::readCoordinateMatrix<T>(parser);
+}
+
+/**
+ * Records are parsed on the calling thread while previously parsed ones
+ * are factorized by pool workers, one matrix per worker. Results are
+ * printed in input order as soon as all preceding ones are ready.
+ */
+void runBatch(io::TextParser& parser, matrix::ThreadPool& pool) {
+  std::deque<std::future<double>> pending;
+  auto max_pending = 2 * pool.size();
+  auto print_front = [&] {
+    std::cout << pending.front().get() << '\n';
+    pending.pop_front();
+  };
+  auto front_ready = [&] {
+    return pending.front().wait_for(std::chrono::seconds(0)) ==
+           std::future_status::ready;
+  };
+
+  while (!parser.atEnd()) {
+    auto m = readText<double>(parser);
+    pending.push_back(pool.submit([m = std::move(m)] { return m.det(); }));
+    // bounds memory held by parsed but not yet computed records
+    if (pending.size() > max_pending) {
+      print_front();
+    }
+
+    while (!pending.empty() && front_ready()) {
+      print_front();
+    }
+  }
+
+  while (!pending.empty()) {
+    print_front();
+  }
+  std::cout.flush();
+}
+
+void printStats(std::ostream& os, Stats format, double wall_seconds) {
+  using vector::stats::Phase;
+  constexpr Phase kPhases[] = {Phase::kParse, Phase::kConvert,
+                               Phase::kPivotSearch, Phase::kRowSwap,
+                               Phase::kElimination};
+  auto s = vector::stats::snapshot();
+  os << std::fixed << std::setprecision(3);
+  if (format == Stats::kJson) {
+    os << "{\"wall_ms\": " << wall_seconds * 1e3 << ", \"phases_ms\": {";
+    for (auto phase : kPhases) {
+      os << (phase == Phase::kParse ? "" : ", ") << '"'
+         << vector::stats::phaseName(phase)
+         << "\": " << s.phaseSeconds(phase) * 1e3;
+    }
+    os << "}, \"bytes_allocated\": " << s.bytes_allocated
+       << ", \"allocations\": " << s.allocations
+       << ", \"reallocations\": " << s.reallocations
+       << ", \"flops\": " << static_cast<std::uint64_t>(s.flops)
+       << ", \"gflops\": " << s.gflops()
+       << "}\n";
+    return;
+  }
+
+  os << "wall time        " << std::setw(12) << wall_seconds * 1e3
+     << " ms\n";
+  for (auto phase : kPhases) {
+    os << std::left << std::setw(17) << vector::stats::phaseName(phase)
+       << std::right << std::setw(12) << s.phaseSeconds(phase) * 1e3
+       << " ms\n";
+  }
+  os << "allocated        " << std::setw(12) << s.bytes_allocated
+     << " bytes in " << s.allocations << " allocations, "
+     << s.reallocations << " reallocations\n"
+     << "factorization    " << std::setw(12) << s.gflops() << " GFLOP/s\n";
+}
+
+void run(const Options& opts) {
+  matrix::ThreadPool pool;
+  matrix::LuOptions lu_opts;
+  lu_opts.pool = &pool;
+
+  if (opts.exact) {
+    if (opts.format != Format::kText || opts.batch ||
+        !opts.write_binary.empty() || !opts.out_of_core.empty()) {
+      throw std::runtime_error("exact mode supports single text input only");
+    }
+
+    auto input = openInput(opts);
+    io::TextParser parser(input.view());
+    auto m = readText<long long>(parser, &pool);
+    std::cout << m.exactDet(&pool) << std::endl;
+    return;
+  }
+
+  if (!opts.out_of_core.empty()) {
+    if (opts.format == Format::kCoo || opts.batch ||
+        !opts.write_binary.empty()) {
+      throw std::runtime_error(
+          "out-of-core mode supports single text or binary input only");
+    }
+    std::cout << outOfCoreDet(opts, pool) << std::endl;
+    return;
+  }
+
+  if (opts.batch) {
+    if (opts.format != Format::kText || !opts.write_binary.empty()) {
+      throw std::runtime_error("batch mode supports text input only");
+    }
+
+    if (opts.input.empty()) {
+      io::TextParser parser(STDIN_FILENO);
+      runBatch(parser, pool);
+    } else {
+      auto input = io::InputBuffer::fromFile(opts.input);
+      io::TextParser parser(input.view());
+      runBatch(parser, pool);
+    }
+    return;
+  }
+
+  if (opts.format == Format::kBinary) {
+    if (!opts.write_binary.empty()) {
+      throw std::runtime_error("input is already binary");
+    }
+    std::cout << binaryDet(io::MappedMatrix(openInput(opts)), lu_opts)
+              << std::endl;
+    return;
+  }
+
+  auto input = openInput(opts);
+  io::TextParser parser(input.view());
+  if (opts.format == Format::kCoo && opts.write_binary.empty()) {
+    std::cout << readCoo<double>(parser).det() << std::endl;
+    return;
+  }
+
+  auto m = opts.format == Format::kCoo ? readCoo<double>(parser).toDense()
+                                       : readText<double>(parser, &pool);
+  if (!opts.write_binary.empty()) {
+    std::ofstream os(opts.write_binary, std::ios::binary);
+    io::writeBinary(os, m);
+    return;
+  }
+
+  std::cout << m.det(lu_opts) << std::endl;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) try {
+  auto opts = parseOptions(argc, argv);
+  if (opts.stats != Stats::kNone && !vector::stats::kEnabled) {
+    throw std::runtime_error(
+        "statistics are not available, rebuild with -DENABLE_STATS=ON");
+  }
 
-int main() try {
-  std::cin.exceptions(std::ios::eofbit | std::ios::failbit);
-  std::size_t n;
-  std::cin >> n;
-  matrix::Matrix<double> m(n, n, std::istream_iterator<double>(std::cin));
-  std::cout << m.det() << std::endl;
+  auto start = std::chrono::steady_clock::now();
+  run(opts);
+  if (opts.stats != Stats::kNone) {
+    std::chrono::duration<double> wall =
+        std::chrono::steady_clock::now() - start;
+    printStats(std::cerr, opts.stats, wall.count());
+  }
   return 0;
 } catch (std::exception& ex) {
   std::cerr << ex.what() << std::endl;
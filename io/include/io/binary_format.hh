@@ -0,0 +1,258 @@
+/**
+ * Binary matrix file format.
+ *
+ * File starts with 64-byte BinaryHeader followed (at data_offset, aligned
+ * to header alignment) by raw elements in native byte order:
+ *   row-major: rows lines of ld elements, first cols of them are used;
+ *   col-major: cols lines of ld elements, first rows of them are used;
+ *   panels: column panels of ld columns one after another, each one
+ *     row-major rows x (its width) block, see io/out_of_core.hh.
+ * Reader maps the file and refers to elements in place, so loading costs
+ * only page-in.
+ */
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+#include "io/input_buffer.hh"
+#include "matrix/matrix.hh"
+#include "matrix/matrix_view.hh"
+
+namespace io {
+
+constexpr char kBinaryMagic[8] = {'M', 'A', 'T', 'R', 'I', 'X', 'B', '\0'};
+constexpr std::uint32_t kBinaryVersion = 1;
+constexpr std::uint32_t kByteOrderMark = 0x01020304;
+constexpr std::uint32_t kDefaultBinaryAlignment = 64;
+
+enum class ElemType : std::uint32_t {
+  kFloat32 = 1,
+  kFloat64 = 2,
+  kInt32 = 3,
+  kInt64 = 4,
+};
+
+enum class Layout : std::uint32_t {
+  kRowMajor = 0,
+  kColMajor = 1,
+  kPanels = 2,
+};
+
+struct BinaryHeader {
+  char magic[8];
+  std::uint32_t version;
+  std::uint32_t byte_order;  ///< kByteOrderMark as written by the producer
+  ElemType elem_type;
+  Layout layout;
+  std::uint64_t rows;
+  std::uint64_t cols;
+  std::uint64_t ld;  ///< elements between starts of adjacent lines
+  std::uint32_t alignment;  ///< of data_offset, bytes
+  std::uint32_t reserved;
+  std::uint64_t data_offset;
+};
+
+static_assert(sizeof(BinaryHeader) == 64);
+static_assert(std::is_trivially_copyable_v<BinaryHeader>);
+
+/**
+ * FOR INTERNAL PURPOSES ONLY. DO NOT USE IN USER PROGRAM
+ */
+namespace detail {
+
+template <typename T>
+constexpr ElemType elemTypeOf() noexcept {
+  if constexpr (std::is_same_v<T, float>) {
+    return ElemType::kFloat32;
+  } else if constexpr (std::is_same_v<T, double>) {
+    return ElemType::kFloat64;
+  } else if constexpr (std::is_same_v<T, std::int32_t>) {
+    return ElemType::kInt32;
+  } else {
+    static_assert(std::is_same_v<T, std::int64_t>,
+                  "type is not supported by binary format");
+    return ElemType::kInt64;
+  }
+}
+
+inline std::size_t elemSize(ElemType type) {
+  switch (type) {
+    case ElemType::kFloat32:
+    case ElemType::kInt32:
+      return 4;
+    case ElemType::kFloat64:
+    case ElemType::kInt64:
+      return 8;
+  }
+  throw std::runtime_error("BinaryHeader: unknown element type");
+}
+
+}  // namespace detail
+
+/**
+ * Writes row-major matrix with rows padded to ld elements. View may have
+ * any strides, e.g. transposed or submatrix one.
+ */
+template <typename T>
+void writeBinary(std::ostream& os, matrix::MatrixView<T> m,
+                 std::size_t ld = 0,
+                 std::uint32_t alignment = kDefaultBinaryAlignment) {
+  ld = std::max(ld, m.cols());
+  if (alignment < sizeof(BinaryHeader) || (alignment & (alignment - 1))) {
+    throw std::runtime_error("writeBinary(): invalid alignment");
+  }
+
+  BinaryHeader hdr{};
+  std::memcpy(hdr.magic, kBinaryMagic, sizeof(hdr.magic));
+  hdr.version = kBinaryVersion;
+  hdr.byte_order = kByteOrderMark;
+  hdr.elem_type = detail::elemTypeOf<T>();
+  hdr.layout = Layout::kRowMajor;
+  hdr.rows = m.rows();
+  hdr.cols = m.cols();
+  hdr.ld = ld;
+  hdr.alignment = alignment;
+  hdr.data_offset = alignment;
+
+  os.write(reinterpret_cast<const char*>(&hdr), sizeof(hdr));
+  std::string pad(
+      std::max(alignment - sizeof(hdr), (ld - m.cols()) * sizeof(T)), '\0');
+  os.write(pad.data(), alignment - sizeof(hdr));
+  for (std::size_t i = 0; i < m.rows(); ++i) {
+    auto row = m.row(i);
+    if (row.isContiguous()) {
+      os.write(reinterpret_cast<const char*>(row.data()), m.cols() * sizeof(T));
+    } else {
+      auto elems = row.toVector();
+      os.write(reinterpret_cast<const char*>(elems.data()),
+               m.cols() * sizeof(T));
+    }
+    os.write(pad.data(), (ld - m.cols()) * sizeof(T));
+  }
+
+  if (!os) {
+    throw std::runtime_error("writeBinary(): write failed");
+  }
+}
+
+template <typename T>
+void writeBinary(std::ostream& os, const matrix::Matrix<T>& m,
+                 std::size_t ld = 0,
+                 std::uint32_t alignment = kDefaultBinaryAlignment) {
+  writeBinary(os, matrix::MatrixView<T>(m), ld, alignment);
+}
+
+/**
+ * Binary matrix file mapped into memory.
+ */
+class MappedMatrix final {
+ public:  // constructors
+  static MappedMatrix fromFile(const std::string& path) {
+    return MappedMatrix(InputBuffer::fromFile(path));
+  }
+
+  /** Does not take ownership of fd */
+  static MappedMatrix fromFd(int fd) {
+    return MappedMatrix(InputBuffer::fromFd(fd));
+  }
+
+  /** Validates header against buffer contents */
+  explicit MappedMatrix(InputBuffer&& buf) : buf_(std::move(buf)) {
+    if (buf_.size() < sizeof(BinaryHeader)) {
+      throw std::runtime_error("MappedMatrix: file is too short");
+    }
+    std::memcpy(&hdr_, buf_.data(), sizeof(hdr_));
+
+    if (std::memcmp(hdr_.magic, kBinaryMagic, sizeof(kBinaryMagic))) {
+      throw std::runtime_error("MappedMatrix: bad magic");
+    }
+
+    if (hdr_.version != kBinaryVersion) {
+      throw std::runtime_error("MappedMatrix: unsupported version " +
+                               std::to_string(hdr_.version));
+    }
+
+    if (hdr_.byte_order != kByteOrderMark) {
+      throw std::runtime_error("MappedMatrix: byte order mismatch");
+    }
+
+    if (hdr_.layout == Layout::kPanels) {
+      throw std::runtime_error("MappedMatrix: panel layout is read by "
+                               "PanelFile");
+    }
+
+    if (hdr_.layout != Layout::kRowMajor &&
+        hdr_.layout != Layout::kColMajor) {
+      throw std::runtime_error("MappedMatrix: unknown layout");
+    }
+
+    auto lines = hdr_.layout == Layout::kRowMajor ? hdr_.rows : hdr_.cols;
+    auto line_len = hdr_.layout == Layout::kRowMajor ? hdr_.cols : hdr_.rows;
+    auto elem_size = detail::elemSize(hdr_.elem_type);
+    if (hdr_.ld < line_len) {
+      throw std::runtime_error("MappedMatrix: ld is less than line length");
+    }
+
+    auto aligned = hdr_.alignment && !(hdr_.alignment & (hdr_.alignment - 1));
+    if (!aligned || hdr_.data_offset % hdr_.alignment ||
+        hdr_.data_offset < sizeof(BinaryHeader)) {
+      throw std::runtime_error("MappedMatrix: bad data offset");
+    }
+
+    // elements are referred to in place, so they must be aligned as T
+    auto address = reinterpret_cast<std::uintptr_t>(buf_.data()) +
+                   hdr_.data_offset;
+    if (address % elem_size) {
+      throw std::runtime_error(
+          "MappedMatrix: data offset is not aligned to element size");
+    }
+
+    constexpr auto kMax = std::numeric_limits<std::uint64_t>::max();
+    auto avail = buf_.size() - std::min<std::uint64_t>(hdr_.data_offset,
+                                                       buf_.size());
+    if (lines && hdr_.ld > kMax / lines) {
+      throw std::runtime_error("MappedMatrix: dimensions are too large");
+    }
+
+    auto used = lines ? (lines - 1) * hdr_.ld + line_len : 0;
+    if (used > avail / elem_size) {
+      throw std::runtime_error("MappedMatrix: file is truncated");
+    }
+  }
+
+ public:  // accessors
+  const BinaryHeader& header() const noexcept { return hdr_; }
+  ElemType elemType() const noexcept { return hdr_.elem_type; }
+
+  /**
+   * View over mapped elements. Column-major file is viewed with row
+   * stride 1 and column stride ld, i.e. as the matrix it stores.
+   */
+  template <typename T>
+  matrix::MatrixView<T> view() const {
+    if (detail::elemTypeOf<T>() != hdr_.elem_type) {
+      throw std::runtime_error("MappedMatrix::view(): element type mismatch");
+    }
+
+    auto* data = reinterpret_cast<const T*>(buf_.data() + hdr_.data_offset);
+    if (hdr_.layout == Layout::kColMajor) {
+      return matrix::MatrixView<T>(data, hdr_.rows, hdr_.cols, 1, hdr_.ld);
+    }
+    return matrix::MatrixView<T>(data, hdr_.rows, hdr_.cols, hdr_.ld);
+  }
+
+ private:
+  InputBuffer buf_;
+  BinaryHeader hdr_;
+};
+
+}  // namespace io
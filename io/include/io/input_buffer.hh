@@ -0,0 +1,147 @@
+/**
+ * Whole input available as one contiguous read-only character range.
+ */
+#pragma once
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <utility>
+
+#include "vector/vector.hh"
+
+namespace io {
+
+/**
+ * Regular files are memory-mapped, so no copy is made and pages are
+ * brought in lazily by kernel. Pipes and terminals are read in large
+ * blocks into owned storage.
+ */
+class InputBuffer final {
+  static constexpr std::size_t kBlockSize = std::size_t{1} << 20;
+
+ public:  // constructors and destructor
+  static InputBuffer fromFile(const std::string& path) {
+    auto fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+      throw std::system_error(errno, std::generic_category(),
+                              "InputBuffer: cannot open " + path);
+    }
+
+    try {
+      auto buf = fromFd(fd);
+      ::close(fd);
+      return buf;
+    } catch (...) {
+      ::close(fd);
+      throw;
+    }
+  }
+
+  /** Does not take ownership of fd */
+  static InputBuffer fromFd(int fd) {
+    InputBuffer buf;
+    struct stat st;
+    if (::fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0) {
+      buf.map(fd, static_cast<std::size_t>(st.st_size));
+    } else {
+      buf.readAll(fd);
+    }
+    return buf;
+  }
+
+  InputBuffer(InputBuffer&& rhs) noexcept
+      : storage_(std::move(rhs.storage_)),
+        data_(std::exchange(rhs.data_, nullptr)),
+        size_(std::exchange(rhs.size_, 0)),
+        mapped_(std::exchange(rhs.mapped_, false)) {}
+
+  InputBuffer& operator=(InputBuffer&& rhs) noexcept {
+    InputBuffer tmp(std::move(rhs));
+    std::swap(storage_, tmp.storage_);
+    std::swap(data_, tmp.data_);
+    std::swap(size_, tmp.size_);
+    std::swap(mapped_, tmp.mapped_);
+    return *this;
+  }
+
+  InputBuffer(const InputBuffer&) = delete;
+  InputBuffer& operator=(const InputBuffer&) = delete;
+
+  ~InputBuffer() {
+    if (mapped_) {
+      ::munmap(const_cast<char*>(data_), size_);
+    }
+  }
+
+ public:  // accessors
+  const char* data() const noexcept { return data_; }
+  std::size_t size() const noexcept { return size_; }
+  std::string_view view() const noexcept { return {data_, size_}; }
+  bool isMapped() const noexcept { return mapped_; }
+
+ private:
+  InputBuffer() = default;
+
+  void map(int fd, std::size_t size) {
+    auto* p = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (p == MAP_FAILED) {
+      // e.g. file systems without mmap support
+      readAll(fd);
+      return;
+    }
+
+    ::madvise(p, size, MADV_SEQUENTIAL);
+    data_ = static_cast<const char*>(p);
+    size_ = size;
+    mapped_ = true;
+  }
+
+  /**
+   * Capacity grows geometrically and blocks are read straight into it,
+   * so that input is copied O(1) times on average and never zero-filled.
+   */
+  void readAll(int fd) {
+    for (;;) {
+      auto size = storage_.size();
+      if (storage_.capacity() - size < kBlockSize) {
+        storage_.reserve(std::max(2 * storage_.capacity(), size + kBlockSize));
+      }
+
+      auto got = ::read(fd, storage_.data() + size, storage_.capacity() - size);
+      if (got < 0) {
+        if (errno == EINTR) {
+          continue;
+        }
+        throw std::system_error(errno, std::generic_category(),
+                                "InputBuffer: read failed");
+      }
+
+      if (got == 0) {
+        break;
+      }
+      // bytes are already there, trivial elements are not initialized
+      storage_.resize(size + static_cast<std::size_t>(got),
+                      vector::kDefaultInit);
+    }
+
+    data_ = storage_.data();
+    size_ = storage_.size();
+  }
+
+ private:
+  vector::Vector<char> storage_;
+  const char* data_ = nullptr;
+  std::size_t size_ = 0;
+  bool mapped_ = false;
+};
+
+}  // namespace io
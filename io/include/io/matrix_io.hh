@@ -0,0 +1,58 @@
+/**
+ * Reading matrices in driver input format.
+ */
+#pragma once
+
+#include <cstddef>
+
+#include "io/text_parser.hh"
+#include "matrix/matrix.hh"
+#include "matrix/sparse_matrix.hh"
+#include "matrix/thread_pool.hh"
+#include "vector/vector.hh"
+
+namespace io {
+
+/**
+ * Reads square matrix: size n followed by n * n row-major elements.
+ * Elements are parsed directly into storage of the result.
+ */
+template <typename T>
+matrix::Matrix<T> readSquareMatrix(TextParser& parser) {
+  auto n = parser.next<std::size_t>();
+  matrix::Matrix<T> m(n, n, vector::kDefaultInit);
+  parser.read(m.data(), n * n);
+  return m;
+}
+
+/** Same, elements are parsed on pool threads, see TextParser::read() */
+template <typename T>
+matrix::Matrix<T> readSquareMatrix(TextParser& parser,
+                                   matrix::ThreadPool& pool) {
+  auto n = parser.next<std::size_t>();
+  matrix::Matrix<T> m(n, n, vector::kDefaultInit);
+  parser.read(m.data(), n * n, pool);
+  return m;
+}
+
+/**
+ * Reads square sparse matrix in coordinate format: size n and number of
+ * entries nnz followed by nnz triples "row col value" with 0-based
+ * indices in any order. Repeated positions are summed up.
+ */
+template <typename T>
+matrix::SparseMatrix<T> readCoordinateMatrix(TextParser& parser) {
+  auto n = parser.next<std::size_t>();
+  auto nnz = parser.next<std::size_t>();
+  vector::Vector<matrix::Triplet<T>> triplets;
+  triplets.reserve(nnz);
+  for (std::size_t p = 0; p < nnz; ++p) {
+    auto row = parser.next<std::size_t>();
+    auto col = parser.next<std::size_t>();
+    auto value = parser.next<T>();
+    triplets.push_back({row, col, value});
+  }
+  return matrix::SparseMatrix<T>(n, n, triplets.begin(), triplets.end());
+}
+
+}  // namespace io
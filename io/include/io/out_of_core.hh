@@ -0,0 +1,423 @@
+/**
+ * Determinants of matrices larger than memory.
+ *
+ * Matrix is kept on disk in panel layout of binary format: column panels
+ * of width columns one after another, each one stored as row-major
+ * n x (its width) block, so that any range of rows of a panel is one
+ * contiguous read. Width is chosen so that kPanelBuffers panels fit into
+ * memory budget.
+ */
+#pragma once
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <future>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <utility>
+
+#include "io/binary_format.hh"
+#include "io/text_parser.hh"
+#include "matrix/detail/gemm.hh"
+#include "matrix/detail/lu_kernels.hh"
+#include "matrix/matrix_view.hh"
+#include "matrix/thread_pool.hh"
+#include "vector/stats.hh"
+#include "vector/vector.hh"
+
+namespace io {
+
+/** Target panel, source panel and the one being prefetched */
+constexpr std::size_t kPanelBuffers = 3;
+constexpr std::uint32_t kPanelAlignment = 4096;
+
+/**
+ * Widest panel of n x n matrix of doubles such that kPanelBuffers of
+ * them fit into budget bytes.
+ */
+inline std::size_t outOfCorePanelWidth(std::size_t n, std::size_t budget) {
+  if (!n) {
+    throw std::runtime_error("outOfCorePanelWidth(): matrix size must be > 0");
+  }
+
+  auto width = budget / (kPanelBuffers * n * sizeof(double));
+  if (!width) {
+    throw std::runtime_error(
+        "outOfCorePanelWidth(): memory budget is too small, " +
+        std::to_string(kPanelBuffers * n * sizeof(double)) +
+        " bytes at least are required");
+  }
+  return std::min(width, n);
+}
+
+/**
+ * FOR INTERNAL PURPOSES ONLY. DO NOT USE IN USER PROGRAM
+ */
+namespace detail {
+
+inline void preadAll(int fd, char* dst, std::size_t size,
+                     std::uint64_t offset) {
+  while (size) {
+    auto res = ::pread(fd, dst, size, static_cast<off_t>(offset));
+    if (res < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      throw std::system_error(errno, std::generic_category(),
+                              "PanelFile: read failed");
+    }
+    if (!res) {
+      throw std::runtime_error("PanelFile: file is truncated");
+    }
+    dst += res;
+    size -= static_cast<std::size_t>(res);
+    offset += static_cast<std::uint64_t>(res);
+  }
+}
+
+inline void pwriteAll(int fd, const char* src, std::size_t size,
+                      std::uint64_t offset) {
+  while (size) {
+    auto res = ::pwrite(fd, src, size, static_cast<off_t>(offset));
+    if (res < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      throw std::system_error(errno, std::generic_category(),
+                              "PanelFile: write failed");
+    }
+    src += res;
+    size -= static_cast<std::size_t>(res);
+    offset += static_cast<std::uint64_t>(res);
+  }
+}
+
+}  // namespace detail
+
+/**
+ * Square matrix of doubles in panel layout, accessed by positioned reads
+ * and writes of row ranges of panels. Reads may run concurrently with
+ * each other and with writes into other panels.
+ */
+class PanelFile final {
+ public:  // constructors and destructor
+  /** Creates or truncates file for n x n matrix with zero elements */
+  static PanelFile create(const std::string& path, std::size_t n,
+                          std::size_t width) {
+    if (!n || !width || width > n) {
+      throw std::runtime_error("PanelFile::create(): invalid dimensions");
+    }
+
+    PanelFile file(openFd(path, O_RDWR | O_CREAT | O_TRUNC));
+    auto& hdr = file.hdr_;
+    std::memcpy(hdr.magic, kBinaryMagic, sizeof(hdr.magic));
+    hdr.version = kBinaryVersion;
+    hdr.byte_order = kByteOrderMark;
+    hdr.elem_type = ElemType::kFloat64;
+    hdr.layout = Layout::kPanels;
+    hdr.rows = n;
+    hdr.cols = n;
+    hdr.ld = width;
+    hdr.alignment = kPanelAlignment;
+    hdr.data_offset = kPanelAlignment;
+
+    detail::pwriteAll(file.fd_, reinterpret_cast<const char*>(&hdr),
+                      sizeof(hdr), 0);
+    auto size = hdr.data_offset + n * n * sizeof(double);
+    if (::ftruncate(file.fd_, static_cast<off_t>(size))) {
+      throw std::system_error(errno, std::generic_category(),
+                              "PanelFile::create(): cannot resize " + path);
+    }
+    return file;
+  }
+
+  /** Opens existing file for reading and writing, validates header */
+  static PanelFile open(const std::string& path) {
+    PanelFile file(openFd(path, O_RDWR));
+    auto& hdr = file.hdr_;
+    detail::preadAll(file.fd_, reinterpret_cast<char*>(&hdr), sizeof(hdr),
+                     0);
+
+    if (std::memcmp(hdr.magic, kBinaryMagic, sizeof(kBinaryMagic))) {
+      throw std::runtime_error("PanelFile: bad magic");
+    }
+
+    if (hdr.version != kBinaryVersion) {
+      throw std::runtime_error("PanelFile: unsupported version " +
+                               std::to_string(hdr.version));
+    }
+
+    if (hdr.byte_order != kByteOrderMark) {
+      throw std::runtime_error("PanelFile: byte order mismatch");
+    }
+
+    if (hdr.layout != Layout::kPanels ||
+        hdr.elem_type != ElemType::kFloat64) {
+      throw std::runtime_error("PanelFile: not a panel file of doubles");
+    }
+
+    if (!hdr.rows || hdr.rows != hdr.cols || !hdr.ld || hdr.ld > hdr.cols) {
+      throw std::runtime_error("PanelFile: invalid dimensions");
+    }
+
+    if (hdr.data_offset < sizeof(BinaryHeader)) {
+      throw std::runtime_error("PanelFile: bad data offset");
+    }
+
+    struct stat st;
+    if (::fstat(file.fd_, &st)) {
+      throw std::system_error(errno, std::generic_category(),
+                              "PanelFile: cannot stat " + path);
+    }
+    auto avail = static_cast<std::uint64_t>(st.st_size);
+    if (avail < hdr.data_offset ||
+        (avail - hdr.data_offset) / sizeof(double) / hdr.rows < hdr.cols) {
+      throw std::runtime_error("PanelFile: file is truncated");
+    }
+    return file;
+  }
+
+  PanelFile(PanelFile&& rhs) noexcept
+      : fd_(std::exchange(rhs.fd_, -1)), hdr_(rhs.hdr_) {}
+
+  PanelFile& operator=(PanelFile&& rhs) noexcept {
+    std::swap(fd_, rhs.fd_);
+    std::swap(hdr_, rhs.hdr_);
+    return *this;
+  }
+
+  PanelFile(const PanelFile&) = delete;
+  PanelFile& operator=(const PanelFile&) = delete;
+
+  ~PanelFile() {
+    if (fd_ >= 0) {
+      ::close(fd_);
+    }
+  }
+
+ public:  // accessors
+  const BinaryHeader& header() const noexcept { return hdr_; }
+  std::size_t size() const noexcept { return hdr_.rows; }
+  std::size_t panelWidth() const noexcept { return hdr_.ld; }
+
+  std::size_t numPanels() const noexcept {
+    return (hdr_.cols + hdr_.ld - 1) / hdr_.ld;
+  }
+
+  /** Width of panel, the last one may be narrower */
+  std::size_t panelCols(std::size_t panel) const noexcept {
+    return std::min<std::size_t>(hdr_.ld, hdr_.cols - panel * hdr_.ld);
+  }
+
+ public:  // input/output
+  /** Reads rows [begin, end) of panel into dst, rows are contiguous */
+  void readRows(std::size_t panel, std::size_t begin, std::size_t end,
+                double* dst) const {
+    detail::preadAll(fd_, reinterpret_cast<char*>(dst),
+                     (end - begin) * panelCols(panel) * sizeof(double),
+                     offset(panel, begin));
+  }
+
+  void writeRows(std::size_t panel, std::size_t begin, std::size_t end,
+                 const double* src) {
+    detail::pwriteAll(fd_, reinterpret_cast<const char*>(src),
+                      (end - begin) * panelCols(panel) * sizeof(double),
+                      offset(panel, begin));
+  }
+
+ private:
+  explicit PanelFile(int fd) noexcept : fd_(fd), hdr_() {}
+
+  static int openFd(const std::string& path, int flags) {
+    auto fd = ::open(path.c_str(), flags, 0644);
+    if (fd < 0) {
+      throw std::system_error(errno, std::generic_category(),
+                              "PanelFile: cannot open " + path);
+    }
+    return fd;
+  }
+
+  std::uint64_t offset(std::size_t panel, std::size_t row) const noexcept {
+    auto panel_begin = std::uint64_t{hdr_.rows} * panel * hdr_.ld;
+    return hdr_.data_offset +
+           (panel_begin + std::uint64_t{row} * panelCols(panel)) *
+               sizeof(double);
+  }
+
+ private:
+  int fd_;
+  BinaryHeader hdr_;
+};
+
+/**
+ * Writes square matrix into new panel file at path, panel width is chosen
+ * by outOfCorePanelWidth(). View may have any strides, e.g. one of
+ * MappedMatrix, and is read panel by panel.
+ */
+template <typename T>
+PanelFile writePanels(matrix::MatrixView<T> m, const std::string& path,
+                      std::size_t budget) {
+  if (!m.isSquare()) {
+    throw std::runtime_error("writePanels(): rows_ != cols_");
+  }
+
+  auto n = m.rows();
+  auto file = PanelFile::create(path, n, outOfCorePanelWidth(n, budget));
+  auto width = file.panelWidth();
+  vector::Vector<double> buf(n * width, vector::kDefaultInit);
+  for (std::size_t p = 0; p < file.numPanels(); ++p) {
+    auto col = p * width;
+    auto cols = file.panelCols(p);
+    for (std::size_t i = 0; i < n; ++i) {
+      for (std::size_t j = 0; j < cols; ++j) {
+        buf[i * cols + j] = static_cast<double>(m(i, col + j));
+      }
+    }
+    file.writeRows(p, 0, n, buf.data());
+  }
+  return file;
+}
+
+/**
+ * Same for text input: size n followed by n * n row-major elements.
+ * Rows are parsed in blocks of panel width and scattered into panels, so
+ * only the block is held in memory and parser may stream from a pipe.
+ */
+inline PanelFile writePanels(TextParser& parser, const std::string& path,
+                             std::size_t budget) {
+  auto n = parser.next<std::size_t>();
+  auto file = PanelFile::create(path, n, outOfCorePanelWidth(n, budget));
+  auto width = file.panelWidth();
+  vector::Vector<double> rows(width * n, vector::kDefaultInit);
+  vector::Vector<double> block(width * width, vector::kDefaultInit);
+  for (std::size_t begin = 0; begin < n; begin += width) {
+    auto end = std::min(n, begin + width);
+    parser.read(rows.data(), (end - begin) * n);
+    for (std::size_t p = 0; p < file.numPanels(); ++p) {
+      auto col = p * width;
+      auto cols = file.panelCols(p);
+      for (auto i = begin; i < end; ++i) {
+        std::copy_n(rows.data() + (i - begin) * n + col, cols,
+                    block.data() + (i - begin) * cols);
+      }
+      file.writeRows(p, begin, end, block.data());
+    }
+  }
+  return file;
+}
+
+/**
+ * Determinant of matrix in panel file by left-looking blocked LU with
+ * partial pivoting. Panel k is read whole, then every panel j < k is
+ * read from its diagonal down and applied to it: row interchanges of
+ * panel j are replayed, the triangular solve gives rows of U and GEMM
+ * updates the rows below. Then panel k itself is factorized in memory
+ * by recursive LU and written back from its diagonal down. Reads go in
+ * fixed order, so each one is issued asynchronously as soon as the
+ * previous one completes and overlaps the update with the panel read
+ * before it; write-back is synchronous. I/O amounts to about
+ * n^3 / (2 * width) elements read, so a wider panel, i.e. a larger
+ * budget, directly cuts time spent waiting for the disk.
+ *
+ * File is overwritten: L and U factors of panels end up in it, with row
+ * interchanges of later panels not applied to earlier ones. Computation
+ * runs on pool if it is given.
+ */
+inline double outOfCoreDet(PanelFile& file,
+                           matrix::ThreadPool* pool = nullptr) {
+  auto n = file.size();
+  auto width = file.panelWidth();
+  auto panels = file.numPanels();
+  vector::stats::addFlops(2.0 / 3 * n * n * n);
+
+  vector::Vector<double> buffers(kPanelBuffers * n * width,
+                                 vector::kDefaultInit);
+  vector::Vector<std::size_t> piv(n, vector::kDefaultInit);
+  auto buffer = [&](std::size_t slot) {
+    return buffers.data() + slot * n * width;
+  };
+
+  // declared after buffers, so that pending read completes before they
+  // are freed on exception
+  std::future<void> pending;
+  auto fetch = [&](std::size_t slot, std::size_t panel, std::size_t begin) {
+    auto* dst = buffer(slot);
+    pending = std::async(std::launch::async, [&file, panel, begin, n, dst] {
+      file.readRows(panel, begin, n, dst);
+    });
+  };
+
+  auto det = 1.0;
+  std::size_t target = 0;
+  fetch(target, 0, 0);
+  for (std::size_t k = 0; k < panels; ++k) {
+    pending.get();
+    auto* a = buffer(target);
+    auto col = k * width;
+    auto cols = file.panelCols(k);
+
+    // reads of this step: panels [0, k) from their diagonals down, then
+    // panel k + 1 whole; three buffers add up to slot indices 0 + 1 + 2
+    auto spare = (target + 1) % kPanelBuffers;
+    auto prefetch = [&](std::size_t j) {
+      if (j < k) {
+        fetch(spare, j, j * width);
+      } else if (k + 1 < panels) {
+        fetch(spare, k + 1, 0);
+      }
+    };
+
+    prefetch(0);
+    for (std::size_t j = 0; j < k; ++j) {
+      pending.get();
+      const auto* src = buffer(spare);
+      spare = kPanelBuffers - target - spare;
+      prefetch(j + 1);
+
+      auto diag = j * width;
+      for (auto i = diag; i < diag + width; ++i) {
+        if (piv[i] != i) {
+          vector::stats::ScopedPhase phase(vector::stats::Phase::kRowSwap);
+          std::swap_ranges(a + i * cols, a + (i + 1) * cols,
+                           a + piv[i] * cols);
+        }
+      }
+
+      vector::stats::ScopedPhase phase(vector::stats::Phase::kElimination);
+      matrix::detail::solveUnitLower(src, width, a + diag * cols, cols, width,
+                                     cols, pool);
+      if (diag + width < n) {
+        matrix::detail::gemm(n - diag - width, cols, width, -1.0,
+                             src + width * width, width, 1, a + diag * cols,
+                             cols, 1, a + (diag + width) * cols, cols, pool);
+      }
+    }
+
+    auto* lower = a + col * cols;
+    if (!matrix::detail::luRecursive(lower, n - col, cols, cols, 0, cols,
+                                     piv.data() + col, pool)) {
+      return 0;
+    }
+
+    for (std::size_t i = 0; i < cols; ++i) {
+      if (piv[col + i] != i) {
+        det = -det;
+      }
+      piv[col + i] += col;
+      det *= lower[i * cols + i];
+    }
+    file.writeRows(k, col, n, lower);
+    target = spare;
+  }
+  return det;
+}
+
+}  // namespace io
@@ -0,0 +1,332 @@
+/**
+ * Parser of whitespace-separated numbers over in-memory text.
+ */
+#pragma once
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <type_traits>
+
+#include "matrix/thread_pool.hh"
+#include "vector/vector.hh"
+
+namespace io {
+
+/**
+ * FOR INTERNAL PURPOSES ONLY. DO NOT USE IN USER PROGRAM
+ */
+namespace detail {
+
+/**
+ * Clinger's fast path: decimal with at most 19 digits whose mantissa fits
+ * into 53 bits and power of ten is exactly representable is correctly
+ * rounded by a single multiplication or division.
+ * @return end of the token or nullptr if the fast path does not apply.
+ */
+inline const char* parseFastDouble(const char* first, const char* last,
+                                   double& val) noexcept {
+  static constexpr double kPow10[] = {
+      1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+      1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+  constexpr int kMaxPow = 22;
+  constexpr int kMaxDigits = 19;
+  constexpr std::uint64_t kMaxMantissa = std::uint64_t{1} << 53;
+
+  auto isDigit = [](char c) { return static_cast<unsigned>(c - '0') < 10; };
+  auto* p = first;
+  auto neg = p != last && *p == '-';
+  p += neg;
+
+  std::uint64_t mant = 0;
+  int digits = 0;
+  int exp = 0;
+  for (; p != last && isDigit(*p); ++p, ++digits) {
+    mant = mant * 10 + (*p - '0');
+  }
+  if (p != last && *p == '.') {
+    for (++p; p != last && isDigit(*p); ++p, ++digits, --exp) {
+      mant = mant * 10 + (*p - '0');
+    }
+  }
+
+  if (!digits || digits > kMaxDigits || mant > kMaxMantissa) {
+    return nullptr;
+  }
+
+  if (p != last && (*p == 'e' || *p == 'E')) {
+    ++p;
+    auto exp_neg = p != last && *p == '-';
+    p += p != last && (*p == '-' || *p == '+');
+    if (p == last || !isDigit(*p)) {
+      return nullptr;
+    }
+
+    int e = 0;
+    for (; p != last && isDigit(*p) && e <= kMaxPow; ++p) {
+      e = e * 10 + (*p - '0');
+    }
+    if (p != last && isDigit(*p)) {
+      return nullptr;
+    }
+    exp += exp_neg ? -e : e;
+  }
+
+  if (exp < -kMaxPow || exp > kMaxPow) {
+    return nullptr;
+  }
+
+  auto res = static_cast<double>(mant);
+  res = exp < 0 ? res / kPow10[-exp] : res * kPow10[exp];
+  val = neg ? -res : res;
+  return p;
+}
+
+}  // namespace detail
+
+/**
+ * Converts tokens with std::from_chars directly from the buffer:
+ * no locale, no stream state and no intermediate strings. Short decimal
+ * doubles take the exact fast path above.
+ *
+ * Parser either works over text fully available in memory or streams
+ * from file descriptor through a fixed-size window, which is refilled
+ * only when next token may be cut by the window end. The latter never
+ * waits for more input than needed to complete current token.
+ */
+class TextParser final {
+  static constexpr std::size_t kMaxTokenLength = 128;
+  static constexpr std::size_t kDefaultWindow = std::size_t{1} << 20;
+  // Smaller pieces of text are not worth a task of parallel read()
+  static constexpr std::size_t kMinChunk = std::size_t{1} << 20;
+
+ public:
+  explicit TextParser(std::string_view text) noexcept
+      : begin_(text.data()), cur_(begin_), end_(begin_ + text.size()) {}
+
+  /** Streams from fd, does not take ownership of it */
+  explicit TextParser(int fd, std::size_t window = kDefaultWindow)
+      : window_(std::max(window, 2 * kMaxTokenLength)),
+        begin_(window_.data()),
+        cur_(begin_),
+        end_(begin_),
+        fd_(fd),
+        eof_(false) {}
+
+  TextParser(const TextParser&) = delete;
+  TextParser& operator=(const TextParser&) = delete;
+
+ public:  // parsing
+  /** Reads next number, throws on malformed token or end of input */
+  template <typename T>
+  T next() {
+    T val;
+    parse(val);
+    return val;
+  }
+
+  /** Reads count numbers into dst */
+  template <typename T>
+  void read(T* dst, std::size_t count) {
+    for (std::size_t i = 0; i < count; ++i) {
+      parse(dst[i]);
+    }
+  }
+
+  /**
+   * Reads count numbers into dst on pool threads. Text in memory is cut
+   * into chunks at whitespace, so that no token is split, tokens of
+   * chunks are counted in parallel, and prefix sums of counts give
+   * position in dst of the first token of each chunk. Then chunks are
+   * parsed in parallel straight into dst. Rest of the text is scanned
+   * by counting too, so it is meant for large trailing reads. Streaming
+   * parser and short text are read serially.
+   */
+  template <typename T>
+  void read(T* dst, std::size_t count, matrix::ThreadPool& pool) {
+    skipSpaces();
+    auto len = static_cast<std::size_t>(end_ - cur_);
+    auto num_chunks = std::min(pool.size(), len / kMinChunk);
+    if (!eof_ || num_chunks <= 1 || !count) {
+      read(dst, count);
+      return;
+    }
+
+    vector::Vector<const char*> bounds(num_chunks + 1);
+    bounds[0] = cur_;
+    bounds[num_chunks] = end_;
+    for (std::size_t c = 1; c < num_chunks; ++c) {
+      auto* pos = std::max(bounds[c - 1], cur_ + len / num_chunks * c);
+      bounds[c] = std::find_if(pos, end_, isSpace);
+    }
+
+    // offsets[c] is number of tokens before chunk c
+    vector::Vector<std::size_t> offsets(num_chunks + 1, 0);
+    auto count_chunks = [&](std::size_t first, std::size_t last) {
+      for (auto c = first; c < last; ++c) {
+        offsets[c + 1] = countTokens(bounds[c], bounds[c + 1]);
+      }
+    };
+    pool.parallelFor(0, num_chunks, 1, count_chunks);
+    for (std::size_t c = 0; c < num_chunks; ++c) {
+      offsets[c + 1] += offsets[c];
+    }
+    if (offsets[num_chunks] < count) {
+      throw std::runtime_error("TextParser: unexpected end of input");
+    }
+
+    // chunks after the one with the last token are left alone
+    auto last_chunk = static_cast<std::size_t>(
+        std::lower_bound(offsets.cbegin() + 1, offsets.cend(), count) -
+        offsets.cbegin() - 1);
+    const char* stop = nullptr;
+    auto parse_chunks = [&](std::size_t first, std::size_t last) {
+      for (auto c = first; c < last; ++c) {
+        TextParser chunk(
+            std::string_view(bounds[c], bounds[c + 1] - bounds[c]),
+            offset() + (bounds[c] - cur_));
+        auto n = std::min(offsets[c + 1], count) - offsets[c];
+        chunk.read(dst + offsets[c], n);
+        if (c == last_chunk) {
+          stop = chunk.cur_;
+        }
+      }
+    };
+    pool.parallelFor(0, last_chunk + 1, 1, parse_chunks);
+    cur_ = stop;
+  }
+
+  /** Skips whitespace, true if nothing but whitespace is left */
+  bool atEnd() {
+    skipSpaces();
+    while (cur_ == end_ && !eof_) {
+      refill();
+      skipSpaces();
+    }
+    return cur_ == end_;
+  }
+
+  std::size_t offset() const noexcept { return consumed_ + (cur_ - begin_); }
+
+ private:
+  /** Parser of a chunk of text, reports offsets from base */
+  TextParser(std::string_view text, std::size_t base) noexcept
+      : TextParser(text) {
+    consumed_ = base;
+  }
+
+  static bool isSpace(char c) noexcept {
+    return c == ' ' || (c >= '\t' && c <= '\r');
+  }
+
+  /**
+   * Number of tokens in [first, last), first is at token start or space.
+   * Counts token starts without carried state, so the loop vectorizes.
+   */
+  static std::size_t countTokens(const char* first,
+                                 const char* last) noexcept {
+    if (first == last) {
+      return 0;
+    }
+    std::size_t count = !isSpace(*first);
+    for (auto* p = first + 1; p != last; ++p) {
+      count += isSpace(p[-1]) & !isSpace(*p);
+    }
+    return count;
+  }
+
+  void skipSpaces() noexcept {
+    while (cur_ != end_ && isSpace(*cur_)) {
+      ++cur_;
+    }
+  }
+
+  /**
+   * Token is complete only if a space ends it inside the window, any
+   * number of bytes before window end may still be a prefix of it.
+   */
+  bool hasCompleteToken() const noexcept {
+    return eof_ || std::find_if(cur_, end_, isSpace) != end_;
+  }
+
+  /** Moves unparsed tail to the window start and reads after it */
+  void refill() {
+    auto tail = static_cast<std::size_t>(end_ - cur_);
+    if (tail == window_.size()) {
+      throw std::runtime_error("TextParser: token is too long at offset " +
+                               std::to_string(offset()));
+    }
+
+    consumed_ += cur_ - begin_;
+    std::copy(cur_, end_, window_.data());
+    cur_ = begin_;
+    end_ = begin_ + tail;
+
+    ::ssize_t got;
+    do {
+      got = ::read(fd_, window_.data() + tail, window_.size() - tail);
+    } while (got < 0 && errno == EINTR);
+
+    if (got < 0) {
+      throw std::system_error(errno, std::generic_category(),
+                              "TextParser: read failed");
+    }
+    end_ += got;
+    eof_ = got == 0;
+  }
+
+  template <typename T>
+  void parse(T& val) {
+    skipSpaces();
+    while (!hasCompleteToken()) {
+      refill();
+      skipSpaces();
+    }
+
+    if (cur_ == end_) {
+      throw std::runtime_error("TextParser: unexpected end of input");
+    }
+
+    // from_chars does not accept explicit plus sign unlike istream
+    auto* first = cur_;
+    if (*first == '+' && first + 1 != end_ && *(first + 1) != '-') {
+      ++first;
+    }
+
+    const char* ptr = nullptr;
+    auto ec = std::errc();
+    if constexpr (std::is_same_v<T, double>) {
+      ptr = detail::parseFastDouble(first, end_, val);
+    }
+    if (!ptr) {
+      auto res = std::from_chars(first, end_, val);
+      ptr = res.ptr;
+      ec = res.ec;
+    }
+
+    if (ec != std::errc() || (ptr != end_ && !isSpace(*ptr))) {
+      throw std::runtime_error("TextParser: malformed number at offset " +
+                               std::to_string(offset()));
+    }
+    cur_ = ptr;
+  }
+
+ private:
+  vector::Vector<char> window_;  ///< empty unless streaming
+  const char* begin_;
+  const char* cur_;
+  const char* end_;
+  int fd_ = -1;
+  bool eof_ = true;
+  std::size_t consumed_ = 0;  ///< bytes dropped from the window
+};
+
+}  // namespace io
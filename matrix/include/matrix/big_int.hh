@@ -0,0 +1,171 @@
+/**
+ * Minimal arbitrary precision integer for exact determinants.
+ */
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <ostream>
+#include <string>
+
+#include "detail/modular.hh"
+#include "vector/vector.hh"
+
+namespace matrix {
+
+/**
+ * Sign and magnitude in 64-bit limbs, least significant first.
+ * Supports only what reconstruction of a determinant from its residues
+ * needs: multiply-add by machine words, comparison and conversions.
+ */
+class BigInt final {
+ public:
+  BigInt() = default;
+
+  BigInt(long long value) : negative_(value < 0) {
+    // negation in unsigned arithmetic is defined for LLONG_MIN too
+    auto mag = static_cast<std::uint64_t>(value);
+    if (negative_) {
+      mag = ~mag + 1;
+    }
+    if (mag) {
+      limbs_.push_back(mag);
+    }
+  }
+
+  /** Magnitude hi * 2^64 + lo with given sign */
+  static BigInt fromParts(bool negative, std::uint64_t hi, std::uint64_t lo) {
+    BigInt res;
+    res.limbs_.push_back(lo);
+    res.limbs_.push_back(hi);
+    res.normalize();
+    res.negative_ = negative && !res.isZero();
+    return res;
+  }
+
+ public:  // accessors
+  bool isZero() const noexcept { return limbs_.empty(); }
+  bool isNegative() const noexcept { return negative_; }
+
+  /** Number of significant bits of magnitude */
+  std::size_t bitLength() const noexcept {
+    if (isZero()) {
+      return 0;
+    }
+    auto top = limbs_.back();
+    std::size_t bits = 0;
+    for (; top; top >>= 1) {
+      ++bits;
+    }
+    return (limbs_.size() - 1) * 64 + bits;
+  }
+
+ public:  // modifiers
+  /** Magnitude becomes magnitude * mul + add, sign is kept */
+  BigInt& mulAdd(std::uint64_t mul, std::uint64_t add) {
+    auto carry = static_cast<detail::u128>(add);
+    for (auto& limb : limbs_) {
+      auto cur = static_cast<detail::u128>(limb) * mul + carry;
+      limb = static_cast<std::uint64_t>(cur);
+      carry = cur >> 64;
+    }
+    if (carry) {
+      limbs_.push_back(static_cast<std::uint64_t>(carry));
+    }
+    normalize();
+    return *this;
+  }
+
+  BigInt operator-() const {
+    auto res = *this;
+    res.negative_ = !negative_ && !isZero();
+    return res;
+  }
+
+ public:  // conversions
+  /** Nearest double, infinity if out of range */
+  double toDouble() const noexcept {
+    auto res = 0.0;
+    for (auto it = limbs_.crbegin(); it != limbs_.crend(); ++it) {
+      res = res * 0x1p64 + static_cast<double>(*it);
+    }
+    return negative_ ? -res : res;
+  }
+
+  std::string toString() const {
+    if (isZero()) {
+      return "0";
+    }
+
+    // peel off 19 decimal digits at a time
+    constexpr std::uint64_t kChunk = 10'000'000'000'000'000'000ull;
+    auto rest = limbs_;
+    std::string digits;
+    while (!rest.empty()) {
+      detail::u128 rem = 0;
+      for (auto it = rest.end(); it != rest.begin();) {
+        --it;
+        auto cur = (rem << 64) | *it;
+        *it = static_cast<std::uint64_t>(cur / kChunk);
+        rem = cur % kChunk;
+      }
+      while (!rest.empty() && !rest.back()) {
+        rest.pop_back();
+      }
+
+      auto chunk = static_cast<std::uint64_t>(rem);
+      for (int i = 0; i < 19 && (chunk || !rest.empty()); ++i) {
+        digits.push_back(static_cast<char>('0' + chunk % 10));
+        chunk /= 10;
+      }
+    }
+    if (negative_) {
+      digits.push_back('-');
+    }
+    std::reverse(digits.begin(), digits.end());
+    return digits;
+  }
+
+ public:  // comparison
+  /** Compares magnitudes: negative, zero or positive like strcmp */
+  static int compareAbs(const BigInt& lhs, const BigInt& rhs) noexcept {
+    if (lhs.limbs_.size() != rhs.limbs_.size()) {
+      return lhs.limbs_.size() < rhs.limbs_.size() ? -1 : 1;
+    }
+    for (auto i = lhs.limbs_.size(); i-- > 0;) {
+      if (lhs.limbs_[i] != rhs.limbs_[i]) {
+        return lhs.limbs_[i] < rhs.limbs_[i] ? -1 : 1;
+      }
+    }
+    return 0;
+  }
+
+  friend bool operator==(const BigInt& lhs, const BigInt& rhs) noexcept {
+    return lhs.negative_ == rhs.negative_ && !compareAbs(lhs, rhs);
+  }
+
+  friend bool operator!=(const BigInt& lhs, const BigInt& rhs) noexcept {
+    return !(lhs == rhs);
+  }
+
+ private:
+  void normalize() noexcept {
+    while (!limbs_.empty() && !limbs_.back()) {
+      limbs_.pop_back();
+    }
+    if (limbs_.empty()) {
+      negative_ = false;
+    }
+  }
+
+ private:
+  vector::Vector<std::uint64_t> limbs_;
+  bool negative_ = false;
+};
+
+inline std::ostream& operator<<(std::ostream& os, const BigInt& value) {
+  return os << value.toString();
+}
+
+}  // namespace matrix
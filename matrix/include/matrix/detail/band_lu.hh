@@ -0,0 +1,76 @@
+/**
+ * LU factorization kernel for band matrices.
+ */
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+
+#include "matrix/comparator.hh"
+#include "matrix/detail/simd_kernels.hh"
+
+/**
+ * FOR INTERNAL PURPOSES ONLY. DO NOT USE IN USER PROGRAM
+ */
+namespace matrix::detail {
+
+/**
+ * Determinant of n x n row-major matrix with kl subdiagonals and ku
+ * superdiagonals by LU with partial pivoting in O(n * kl * (kl + ku)).
+ * Pivot rows come from at most kl rows below, so U gets kl + ku
+ * superdiagonals and row i of working copy keeps columns
+ * [i - kl, i + kl + ku]. L is not kept since only U is needed.
+ * @param band buffer of n * (2 * kl + ku + 1) elements.
+ */
+template <typename T>
+double bandDet(const T* a, std::size_t n, std::size_t lda, std::size_t kl,
+               std::size_t ku, double* band) {
+  auto w = 2 * kl + ku + 1;
+  std::fill_n(band, n * w, 0.0);
+  for (std::size_t i = 0; i < n; ++i) {
+    auto begin = i > kl ? i - kl : 0;
+    auto end = std::min(n, i + ku + 1);
+    std::copy(a + i * lda + begin, a + i * lda + end,
+              band + i * w + begin + kl - i);
+  }
+
+  auto det = 1.0;
+  for (std::size_t j = 0; j < n; ++j) {
+    // element (i, j) is at band[i * w + j + kl - i]
+    auto last = std::min(n - 1, j + kl);
+    auto p = j;
+    auto max = std::abs(band[j * w + kl]);
+    for (auto i = j + 1; i <= last; ++i) {
+      auto v = std::abs(band[i * w + j + kl - i]);
+      if (v > max) {
+        max = v;
+        p = i;
+      }
+    }
+
+    auto* pivot_row = band + j * w + kl;
+    if (p != j) {
+      std::swap_ranges(pivot_row, pivot_row + kl + ku + 1,
+                       band + p * w + j + kl - p);
+      det = -det;
+    }
+
+    auto pivot = pivot_row[0];
+    if (comparator::isClose(pivot, 0.0)) {
+      return 0;
+    }
+    det *= pivot;
+
+    for (auto i = j + 1; i <= last; ++i) {
+      auto* row = band + i * w + j + kl - i;
+      auto coef = row[0] / pivot;
+      if (coef != 0) {
+        simd::axpy(row + 1, pivot_row + 1, kl + ku, -coef);
+      }
+    }
+  }
+  return det;
+}
+
+}  // namespace matrix::detail
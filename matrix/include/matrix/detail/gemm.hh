@@ -0,0 +1,349 @@
+/**
+ * General matrix multiplication: packed panels, cache blocking
+ * and register-blocked micro-kernels.
+ */
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <type_traits>
+
+#include "matrix/detail/simd_kernels.hh"
+#include "matrix/thread_pool.hh"
+#include "vector/vector.hh"
+
+/**
+ * FOR INTERNAL PURPOSES ONLY. DO NOT USE IN USER PROGRAM
+ */
+namespace matrix::detail {
+
+/**
+ * Blocking parameters. Micro-tile MR x NR lives in registers,
+ * KC x NR sliver of B - in L1, MC x KC block of A - in L2,
+ * KC x NC panel of B - in L3.
+ */
+template <typename T>
+struct GemmBlocking {
+  static constexpr std::size_t kMr = 4;
+  static constexpr std::size_t kNr = 64 / sizeof(T);
+  static constexpr std::size_t kKc = 256;
+  static constexpr std::size_t kMc = 128;
+  static constexpr std::size_t kNc = 4096;
+};
+
+// Products smaller than that (in multiply-adds) are not worth threading.
+constexpr std::size_t kGemmParallelThreshold = std::size_t{1} << 21;
+
+template <typename T>
+using GemmKernel = void (*)(std::size_t, const T*, const T*, T*, std::size_t,
+                            T) noexcept;
+
+/**
+ * C[MR x NR] += alpha * A_panel * B_panel, panels are packed
+ * by packA() and packB().
+ */
+template <typename T>
+void gemmKernelGeneric(std::size_t kc, const T* a, const T* b, T* c,
+                       std::size_t ldc, T alpha) noexcept {
+  constexpr auto kMr = GemmBlocking<T>::kMr;
+  constexpr auto kNr = GemmBlocking<T>::kNr;
+  T acc[kMr][kNr] = {};
+  for (std::size_t p = 0; p < kc; ++p, a += kMr, b += kNr) {
+    for (std::size_t i = 0; i < kMr; ++i) {
+      for (std::size_t j = 0; j < kNr; ++j) {
+        acc[i][j] += a[i] * b[j];
+      }
+    }
+  }
+
+  for (std::size_t i = 0; i < kMr; ++i) {
+    for (std::size_t j = 0; j < kNr; ++j) {
+      c[i * ldc + j] += alpha * acc[i][j];
+    }
+  }
+}
+
+#if MATRIX_SIMD_X86
+
+__attribute__((target("avx2,fma"))) inline void gemmKernelAvx2(
+    std::size_t kc, const double* a, const double* b, double* c,
+    std::size_t ldc, double alpha) noexcept {
+  static_assert(GemmBlocking<double>::kMr == 4 &&
+                GemmBlocking<double>::kNr == 8);
+  auto c00 = _mm256_setzero_pd();
+  auto c01 = _mm256_setzero_pd();
+  auto c10 = _mm256_setzero_pd();
+  auto c11 = _mm256_setzero_pd();
+  auto c20 = _mm256_setzero_pd();
+  auto c21 = _mm256_setzero_pd();
+  auto c30 = _mm256_setzero_pd();
+  auto c31 = _mm256_setzero_pd();
+  for (std::size_t p = 0; p < kc; ++p, a += 4, b += 8) {
+    auto b0 = _mm256_loadu_pd(b);
+    auto b1 = _mm256_loadu_pd(b + 4);
+    auto a0 = _mm256_broadcast_sd(a);
+    c00 = _mm256_fmadd_pd(a0, b0, c00);
+    c01 = _mm256_fmadd_pd(a0, b1, c01);
+    auto a1 = _mm256_broadcast_sd(a + 1);
+    c10 = _mm256_fmadd_pd(a1, b0, c10);
+    c11 = _mm256_fmadd_pd(a1, b1, c11);
+    auto a2 = _mm256_broadcast_sd(a + 2);
+    c20 = _mm256_fmadd_pd(a2, b0, c20);
+    c21 = _mm256_fmadd_pd(a2, b1, c21);
+    auto a3 = _mm256_broadcast_sd(a + 3);
+    c30 = _mm256_fmadd_pd(a3, b0, c30);
+    c31 = _mm256_fmadd_pd(a3, b1, c31);
+  }
+
+  auto al = _mm256_set1_pd(alpha);
+  auto* r0 = c;
+  auto* r1 = c + ldc;
+  auto* r2 = c + 2 * ldc;
+  auto* r3 = c + 3 * ldc;
+  _mm256_storeu_pd(r0, _mm256_fmadd_pd(al, c00, _mm256_loadu_pd(r0)));
+  _mm256_storeu_pd(r0 + 4,
+                   _mm256_fmadd_pd(al, c01, _mm256_loadu_pd(r0 + 4)));
+  _mm256_storeu_pd(r1, _mm256_fmadd_pd(al, c10, _mm256_loadu_pd(r1)));
+  _mm256_storeu_pd(r1 + 4,
+                   _mm256_fmadd_pd(al, c11, _mm256_loadu_pd(r1 + 4)));
+  _mm256_storeu_pd(r2, _mm256_fmadd_pd(al, c20, _mm256_loadu_pd(r2)));
+  _mm256_storeu_pd(r2 + 4,
+                   _mm256_fmadd_pd(al, c21, _mm256_loadu_pd(r2 + 4)));
+  _mm256_storeu_pd(r3, _mm256_fmadd_pd(al, c30, _mm256_loadu_pd(r3)));
+  _mm256_storeu_pd(r3 + 4,
+                   _mm256_fmadd_pd(al, c31, _mm256_loadu_pd(r3 + 4)));
+}
+
+__attribute__((target("avx2,fma"))) inline void gemmKernelAvx2(
+    std::size_t kc, const float* a, const float* b, float* c,
+    std::size_t ldc, float alpha) noexcept {
+  static_assert(GemmBlocking<float>::kMr == 4 &&
+                GemmBlocking<float>::kNr == 16);
+  auto c00 = _mm256_setzero_ps();
+  auto c01 = _mm256_setzero_ps();
+  auto c10 = _mm256_setzero_ps();
+  auto c11 = _mm256_setzero_ps();
+  auto c20 = _mm256_setzero_ps();
+  auto c21 = _mm256_setzero_ps();
+  auto c30 = _mm256_setzero_ps();
+  auto c31 = _mm256_setzero_ps();
+  for (std::size_t p = 0; p < kc; ++p, a += 4, b += 16) {
+    auto b0 = _mm256_loadu_ps(b);
+    auto b1 = _mm256_loadu_ps(b + 8);
+    auto a0 = _mm256_broadcast_ss(a);
+    c00 = _mm256_fmadd_ps(a0, b0, c00);
+    c01 = _mm256_fmadd_ps(a0, b1, c01);
+    auto a1 = _mm256_broadcast_ss(a + 1);
+    c10 = _mm256_fmadd_ps(a1, b0, c10);
+    c11 = _mm256_fmadd_ps(a1, b1, c11);
+    auto a2 = _mm256_broadcast_ss(a + 2);
+    c20 = _mm256_fmadd_ps(a2, b0, c20);
+    c21 = _mm256_fmadd_ps(a2, b1, c21);
+    auto a3 = _mm256_broadcast_ss(a + 3);
+    c30 = _mm256_fmadd_ps(a3, b0, c30);
+    c31 = _mm256_fmadd_ps(a3, b1, c31);
+  }
+
+  auto al = _mm256_set1_ps(alpha);
+  auto* r0 = c;
+  auto* r1 = c + ldc;
+  auto* r2 = c + 2 * ldc;
+  auto* r3 = c + 3 * ldc;
+  _mm256_storeu_ps(r0, _mm256_fmadd_ps(al, c00, _mm256_loadu_ps(r0)));
+  _mm256_storeu_ps(r0 + 8,
+                   _mm256_fmadd_ps(al, c01, _mm256_loadu_ps(r0 + 8)));
+  _mm256_storeu_ps(r1, _mm256_fmadd_ps(al, c10, _mm256_loadu_ps(r1)));
+  _mm256_storeu_ps(r1 + 8,
+                   _mm256_fmadd_ps(al, c11, _mm256_loadu_ps(r1 + 8)));
+  _mm256_storeu_ps(r2, _mm256_fmadd_ps(al, c20, _mm256_loadu_ps(r2)));
+  _mm256_storeu_ps(r2 + 8,
+                   _mm256_fmadd_ps(al, c21, _mm256_loadu_ps(r2 + 8)));
+  _mm256_storeu_ps(r3, _mm256_fmadd_ps(al, c30, _mm256_loadu_ps(r3)));
+  _mm256_storeu_ps(r3 + 8,
+                   _mm256_fmadd_ps(al, c31, _mm256_loadu_ps(r3 + 8)));
+}
+
+#endif  // MATRIX_SIMD_X86
+
+/** Returns micro-kernel for given isa, which must be supported by CPU */
+template <typename T>
+GemmKernel<T> gemmKernel(simd::Isa isa) noexcept {
+#if MATRIX_SIMD_X86
+  if constexpr (std::is_same_v<T, double> || std::is_same_v<T, float>) {
+    if (isa == simd::Isa::kAvx2 || isa == simd::Isa::kAvx512) {
+      return static_cast<GemmKernel<T>>(&gemmKernelAvx2);
+    }
+  }
+#endif
+  return &gemmKernelGeneric<T>;
+}
+
+/**
+ * Packs mc x kc block of A into row micro-panels of height MR,
+ * short panels are padded with zeros.
+ */
+template <typename T>
+void packA(std::size_t mc, std::size_t kc, const T* a, std::size_t rsa,
+           std::size_t csa, T* dst) noexcept {
+  constexpr auto kMr = GemmBlocking<T>::kMr;
+  for (std::size_t ir = 0; ir < mc; ir += kMr) {
+    auto mr = std::min(kMr, mc - ir);
+    for (std::size_t p = 0; p < kc; ++p) {
+      for (std::size_t i = 0; i < mr; ++i) {
+        dst[i] = a[(ir + i) * rsa + p * csa];
+      }
+      std::fill(dst + mr, dst + kMr, T{0});
+      dst += kMr;
+    }
+  }
+}
+
+/**
+ * Packs kc x nc panel of B into column micro-panels of width NR,
+ * short panels are padded with zeros.
+ */
+template <typename T>
+void packB(std::size_t kc, std::size_t nc, const T* b, std::size_t rsb,
+           std::size_t csb, T* dst) noexcept {
+  constexpr auto kNr = GemmBlocking<T>::kNr;
+  for (std::size_t jr = 0; jr < nc; jr += kNr) {
+    auto nr = std::min(kNr, nc - jr);
+    for (std::size_t p = 0; p < kc; ++p) {
+      const auto* src = b + p * rsb + jr * csb;
+      for (std::size_t j = 0; j < nr; ++j) {
+        dst[j] = src[j * csb];
+      }
+      std::fill(dst + nr, dst + kNr, T{0});
+      dst += kNr;
+    }
+  }
+}
+
+/**
+ * Multiplies packed mc x kc block of A by packed kc x nc panel of B.
+ */
+template <typename T>
+void gemmMacroKernel(std::size_t mc, std::size_t nc, std::size_t kc,
+                     const T* a_pack, const T* b_pack, T* c, std::size_t ldc,
+                     T alpha, GemmKernel<T> kernel) noexcept {
+  constexpr auto kMr = GemmBlocking<T>::kMr;
+  constexpr auto kNr = GemmBlocking<T>::kNr;
+  for (std::size_t jr = 0; jr < nc; jr += kNr) {
+    auto nr = std::min(kNr, nc - jr);
+    const auto* b_panel = b_pack + jr * kc;
+    for (std::size_t ir = 0; ir < mc; ir += kMr) {
+      auto mr = std::min(kMr, mc - ir);
+      const auto* a_panel = a_pack + ir * kc;
+      auto* c_tile = c + ir * ldc + jr;
+      if (mr == kMr && nr == kNr) {
+        kernel(kc, a_panel, b_panel, c_tile, ldc, alpha);
+        continue;
+      }
+
+      // edge tile: compute into temporary and add needed part
+      T tmp[kMr * kNr] = {};
+      kernel(kc, a_panel, b_panel, tmp, kNr, alpha);
+      for (std::size_t i = 0; i < mr; ++i) {
+        for (std::size_t j = 0; j < nr; ++j) {
+          c_tile[i * ldc + j] += tmp[i * kNr + j];
+        }
+      }
+    }
+  }
+}
+
+/**
+ * C += alpha * A * B, where A is m x k, B is k x n and C is m x n.
+ * A and B are addressed through row and column strides, so transposed
+ * or strided operands are allowed. C is row-major with leading dimension ldc.
+ * Work is split by blocks of rows of C, so result does not depend on
+ * the number of threads.
+ */
+template <typename T>
+void gemm(std::size_t m, std::size_t n, std::size_t k, T alpha, const T* a,
+          std::size_t rsa, std::size_t csa, const T* b, std::size_t rsb,
+          std::size_t csb, T* c, std::size_t ldc, ThreadPool* pool = nullptr) {
+  using Blocking = GemmBlocking<T>;
+  if (!m || !n || !k) {
+    return;
+  }
+
+  static const auto kernel = gemmKernel<T>(simd::detectIsa());
+  if (m * n * k < kGemmParallelThreshold) {
+    pool = nullptr;
+  }
+
+  auto nc_max = std::min(Blocking::kNc, n);
+  auto kc_max = std::min(Blocking::kKc, k);
+  // Packing buffers are kept between calls to avoid allocations.
+  // Thread pool never runs foreign tasks on a thread waiting in
+  // parallelFor, so these buffers are not reused by nested calls.
+  thread_local vector::Vector<T> b_pack_buf;
+  auto b_pack_sz =
+      kc_max * ((nc_max + Blocking::kNr - 1) / Blocking::kNr * Blocking::kNr);
+  if (b_pack_buf.size() < b_pack_sz) {
+    b_pack_buf.resize(b_pack_sz);
+  }
+  // buffer of calling thread is shared with workers
+  auto* b_pack = b_pack_buf.data();
+  auto num_row_blocks = (m + Blocking::kMc - 1) / Blocking::kMc;
+
+  for (std::size_t jc = 0; jc < n; jc += Blocking::kNc) {
+    auto nc = std::min(Blocking::kNc, n - jc);
+    for (std::size_t pc = 0; pc < k; pc += Blocking::kKc) {
+      auto kc = std::min(Blocking::kKc, k - pc);
+      packB(kc, nc, b + pc * rsb + jc * csb, rsb, csb, b_pack);
+
+      auto do_row_blocks = [&](std::size_t begin, std::size_t end) {
+        thread_local vector::Vector<T> a_pack(Blocking::kMc * Blocking::kKc);
+        for (auto blk = begin; blk < end; ++blk) {
+          auto ic = blk * Blocking::kMc;
+          auto mc = std::min(Blocking::kMc, m - ic);
+          packA(mc, kc, a + ic * rsa + pc * csa, rsa, csa, a_pack.data());
+          gemmMacroKernel(mc, nc, kc, a_pack.data(), b_pack,
+                          c + ic * ldc + jc, ldc, alpha, kernel);
+        }
+      };
+
+      if (pool) {
+        pool->parallelFor(0, num_row_blocks, 1, do_row_blocks);
+      } else {
+        do_row_blocks(0, num_row_blocks);
+      }
+    }
+  }
+}
+
+/**
+ * y += alpha * A * x, A is m x n row-major with leading dimension lda.
+ */
+template <typename T>
+void gemv(std::size_t m, std::size_t n, T alpha, const T* a, std::size_t lda,
+          const T* x, T* y, ThreadPool* pool = nullptr) {
+  auto do_rows = [=](std::size_t begin, std::size_t end) {
+    for (auto i = begin; i < end; ++i) {
+      const auto* row = a + i * lda;
+      // independent accumulators break dependency chain
+      T acc[4] = {};
+      std::size_t j = 0;
+      for (; j + 4 <= n; j += 4) {
+        acc[0] += row[j] * x[j];
+        acc[1] += row[j + 1] * x[j + 1];
+        acc[2] += row[j + 2] * x[j + 2];
+        acc[3] += row[j + 3] * x[j + 3];
+      }
+      for (; j < n; ++j) {
+        acc[0] += row[j] * x[j];
+      }
+      y[i] += alpha * ((acc[0] + acc[1]) + (acc[2] + acc[3]));
+    }
+  };
+
+  if (pool && m * n >= kGemmParallelThreshold) {
+    pool->parallelFor(0, m, 64, do_rows);
+  } else {
+    do_rows(0, m);
+  }
+}
+
+}  // namespace matrix::detail
@@ -0,0 +1,283 @@
+/**
+ * Raw LU factorization kernels working on row-major storage
+ * with arbitrary leading dimension.
+ */
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <type_traits>
+
+#include "matrix/comparator.hh"
+#include "matrix/detail/gemm.hh"
+#include "matrix/detail/simd_kernels.hh"
+#include "matrix/thread_pool.hh"
+#include "vector/aligned_allocator.hh"
+#include "vector/stats.hh"
+
+/**
+ * FOR INTERNAL PURPOSES ONLY. DO NOT USE IN USER PROGRAM
+ */
+namespace matrix::detail {
+
+constexpr std::size_t kDefaultLuBlockSize = 64;
+
+// Column count at which recursive LU stops splitting and eliminates
+// column by column. Small enough for the panel rows to stay in L1.
+constexpr std::size_t kRecursiveLuBase = 16;
+
+using simd::axpy;
+using vector::stats::Phase;
+using vector::stats::ScopedPhase;
+
+/** Element type factorizations of Matrix<T> are computed in */
+template <typename T>
+using FactorType = std::conditional_t<std::is_floating_point_v<T>, T, double>;
+
+/**
+ * Row stride of working copy: rounded up to whole cache lines so that
+ * every row starts aligned, and kept off multiples of page size, which
+ * would map elements of a column into the same cache set.
+ */
+template <typename T>
+std::size_t paddedStride(std::size_t cols) noexcept {
+  constexpr auto kLine = vector::kCacheLineSize / sizeof(T);
+  constexpr std::size_t kPageSize = 4096;
+  auto ld = (cols + kLine - 1) / kLine * kLine;
+  if (ld * sizeof(T) % kPageSize == 0) {
+    ld += kLine;
+  }
+  return ld;
+}
+
+/**
+ * Row of max |a[i * lda + col]| among rows [begin, end), the first one
+ * on ties. Strided scan, one cache line per row.
+ */
+template <typename T>
+std::size_t findPivot(const T* a, std::size_t lda, std::size_t col,
+                      std::size_t begin, std::size_t end) noexcept {
+  auto p = begin;
+  auto max = std::abs(a[begin * lda + col]);
+  for (auto i = begin + 1; i < end; ++i) {
+    auto v = std::abs(a[i * lda + col]);
+    if (v > max) {
+      max = v;
+      p = i;
+    }
+  }
+  return p;
+}
+
+/**
+ * Unblocked factorization of panel [k, k + kb) columns, rows [k, rows).
+ * Rows are swapped over all cols columns, so that L part on the left
+ * stays consistent. Only panel columns are updated. Pivot of the next
+ * column is searched for while rows are eliminated, as its element is
+ * updated in the same cache line, so only the first column of the panel
+ * is scanned apart.
+ * @return false if zero pivot was encountered.
+ */
+template <typename T>
+bool luPanel(T* a, std::size_t rows, std::size_t cols, std::size_t lda,
+             std::size_t k, std::size_t kb, std::size_t* piv) {
+  auto nonsingular = true;
+  auto panel_end = k + kb;
+  std::size_t p;
+  {
+    ScopedPhase phase(Phase::kPivotSearch);
+    p = findPivot(a, lda, k, k, rows);
+  }
+  for (auto j = k; j < panel_end; ++j) {
+    piv[j] = p;
+    if (p != j) {
+      ScopedPhase phase(Phase::kRowSwap);
+      std::swap_ranges(a + j * lda, a + j * lda + cols, a + p * lda);
+    }
+
+    auto* pivot_row = a + j * lda;
+    auto pivot = pivot_row[j];
+    auto next = j + 1;
+    if (comparator::isClose(pivot, static_cast<T>(0))) {
+      // keep going to get complete U, but do not eliminate with this column
+      nonsingular = false;
+      for (auto i = next; i < rows; ++i) {
+        a[i * lda + j] = 0;
+      }
+      if (next < panel_end) {
+        ScopedPhase phase(Phase::kPivotSearch);
+        p = findPivot(a, lda, next, next, rows);
+      }
+      continue;
+    }
+
+    ScopedPhase phase(Phase::kElimination);
+    auto track = next < panel_end;
+    auto max = static_cast<T>(0);
+    p = next;
+    for (auto i = next; i < rows; ++i) {
+      auto* row = a + i * lda;
+      auto coef = row[j] / pivot;
+      row[j] = coef;
+      axpy(row + next, pivot_row + next, panel_end - next, -coef);
+      if (track) {
+        auto v = std::abs(row[next]);
+        if (i == next || v > max) {
+          max = v;
+          p = i;
+        }
+      }
+    }
+  }
+  return nonsingular;
+}
+
+/** Same for square n x n matrix */
+template <typename T>
+bool luPanel(T* a, std::size_t n, std::size_t lda, std::size_t k,
+             std::size_t kb, std::size_t* piv) {
+  return luPanel(a, n, n, lda, k, kb, piv);
+}
+
+/**
+ * Computes U12 = L11^{-1} * A12 for panel [k, k + kb).
+ */
+template <typename T>
+void luSolveRowBlock(T* a, std::size_t n, std::size_t lda, std::size_t k,
+                     std::size_t kb) noexcept {
+  auto panel_end = k + kb;
+  for (auto j = k; j < panel_end; ++j) {
+    const auto* src = a + j * lda + panel_end;
+    for (auto i = j + 1; i < panel_end; ++i) {
+      auto* row = a + i * lda;
+      axpy(row + panel_end, src, n - panel_end, -row[j]);
+    }
+  }
+}
+
+/**
+ * A22 -= L21 * U12 for panel [k, k + kb).
+ */
+template <typename T>
+void luUpdateTrailing(T* a, std::size_t n, std::size_t lda, std::size_t k,
+                      std::size_t kb, ThreadPool* pool) {
+  auto panel_end = k + kb;
+  auto rest = n - panel_end;
+  gemm(rest, rest, kb, static_cast<T>(-1), a + panel_end * lda + k, lda, 1,
+       a + k * lda + panel_end, lda, 1, a + panel_end * lda + panel_end, lda,
+       pool);
+}
+
+/**
+ * Blocked right-looking LU factorization with partial pivoting
+ * of n x n matrix stored row-major with leading dimension lda.
+ * Result is packed: strictly lower part holds L (with implied unit diagonal),
+ * upper part holds U. At step i row i was swapped with row piv[i].
+ * Trailing update is done by packed GEMM. If pool is given, it is split
+ * by blocks of rows between workers. Each element is updated with the same
+ * sequence of operations as in serial case, so the result does not depend
+ * on the number of threads.
+ * @return false if matrix is singular.
+ */
+template <typename T>
+bool luFactorize(T* a, std::size_t n, std::size_t lda, std::size_t* piv,
+                 std::size_t block_size = kDefaultLuBlockSize,
+                 ThreadPool* pool = nullptr) {
+  block_size = std::max(block_size, std::size_t{1});
+  auto nonsingular = true;
+  for (std::size_t k = 0; k < n; k += block_size) {
+    auto kb = std::min(block_size, n - k);
+    nonsingular = luPanel(a, n, lda, k, kb, piv) && nonsingular;
+    if (k + kb == n) {
+      break;
+    }
+    ScopedPhase phase(Phase::kElimination);
+    luSolveRowBlock(a, n, lda, k, kb);
+    luUpdateTrailing(a, n, lda, k, kb, pool);
+  }
+  return nonsingular;
+}
+
+/**
+ * Computes X = L^{-1} * B in place, where L is m x m unit lower triangle
+ * at l, B is m x ncols block at b. L is halved recursively, off-diagonal
+ * blocks are applied by GEMM. L and B may be parts of different buffers.
+ */
+template <typename T>
+void solveUnitLower(const T* l, std::size_t ldl, T* b, std::size_t ldb,
+                    std::size_t m, std::size_t ncols, ThreadPool* pool) {
+  if (m <= kRecursiveLuBase) {
+    for (std::size_t j = 0; j < m; ++j) {
+      const auto* src = b + j * ldb;
+      for (auto i = j + 1; i < m; ++i) {
+        axpy(b + i * ldb, src, ncols, -l[i * ldl + j]);
+      }
+    }
+    return;
+  }
+
+  auto half = m / 2;
+  solveUnitLower(l, ldl, b, ldb, half, ncols, pool);
+  gemm(m - half, ncols, half, static_cast<T>(-1), l + half * ldl, ldl, 1, b,
+       ldb, 1, b + half * ldb, ldb, pool);
+  solveUnitLower(l + half * ldl + half, ldl, b + half * ldb, ldb, m - half,
+                 ncols, pool);
+}
+
+/**
+ * Same for L of rows and columns [k, k + kb) and B of rows [k, k + kb)
+ * and columns [col, col + ncols) of one matrix.
+ */
+template <typename T>
+void luSolveLowerRecursive(T* a, std::size_t lda, std::size_t k,
+                           std::size_t kb, std::size_t col, std::size_t ncols,
+                           ThreadPool* pool) {
+  solveUnitLower(a + k * lda + k, lda, a + k * lda + col, lda, kb, ncols,
+                 pool);
+}
+
+/**
+ * Factorizes columns [k, k + kb), rows [k, rows), by halving the column
+ * range: left half is factorized, right half is updated with it by
+ * triangular solve and GEMM, then factorized itself. Every level of
+ * cache ends up holding some level of recursion, so no block size has
+ * to be tuned. Rows are swapped over cols columns, as in luPanel().
+ * @return false if zero pivot was encountered.
+ */
+template <typename T>
+bool luRecursive(T* a, std::size_t rows, std::size_t cols, std::size_t lda,
+                 std::size_t k, std::size_t kb, std::size_t* piv,
+                 ThreadPool* pool) {
+  if (kb <= kRecursiveLuBase) {
+    return luPanel(a, rows, cols, lda, k, kb, piv);
+  }
+
+  auto half = kb / 2;
+  auto right = k + half;
+  auto right_cols = kb - half;
+  auto nonsingular = luRecursive(a, rows, cols, lda, k, half, piv, pool);
+  {
+    ScopedPhase phase(Phase::kElimination);
+    luSolveLowerRecursive(a, lda, k, half, right, right_cols, pool);
+    gemm(rows - right, right_cols, half, static_cast<T>(-1),
+         a + right * lda + k, lda, 1, a + k * lda + right, lda, 1,
+         a + right * lda + right, lda, pool);
+  }
+  return luRecursive(a, rows, cols, lda, right, right_cols, piv, pool) &&
+         nonsingular;
+}
+
+/**
+ * Recursive cache-oblivious LU factorization with partial pivoting,
+ * same storage and result format as luFactorize(). Nearly all work is
+ * done by GEMM calls, which run on pool if it is given.
+ * @return false if matrix is singular.
+ */
+template <typename T>
+bool luFactorizeRecursive(T* a, std::size_t n, std::size_t lda,
+                          std::size_t* piv, ThreadPool* pool = nullptr) {
+  return luRecursive(a, n, n, lda, 0, n, piv, pool);
+}
+
+}  // namespace matrix::detail
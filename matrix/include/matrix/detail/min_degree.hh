@@ -0,0 +1,146 @@
+/**
+ * Fill-reducing column ordering for sparse LU.
+ */
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <set>
+#include <utility>
+
+#include "vector/vector.hh"
+
+namespace matrix {
+namespace detail {
+
+/**
+ * Approximate minimum degree ordering of the column intersection graph,
+ * where columns are adjacent if they share a row, i.e. the graph of
+ * A^T * A. Its Cholesky fill bounds the fill of LU with any row
+ * pivoting, so ordering columns of A by it keeps factors sparse whatever
+ * pivots are chosen.
+ *
+ * As in COLAMD the graph is never formed: it is kept as a quotient graph
+ * whose elements are rows of A and cliques created by elimination, and
+ * degrees are AMD upper bounds computed from element sizes. Memory is
+ * O(nnz(A) + cols) and each step costs time proportional to the
+ * elements touching the new clique, instead of its squared size.
+ *
+ * Rows with more than max(16, 10 * sqrt(cols)) entries are ignored,
+ * since each of them would make the graph a clique.
+ *
+ * @param row_ptr, col_idx CSR pattern of the matrix.
+ * @return column permutation: k-th eliminated column is order[k].
+ */
+inline vector::Vector<std::size_t> minDegreeOrder(
+    std::size_t rows, std::size_t cols, const std::size_t* row_ptr,
+    const std::size_t* col_idx) {
+  auto dense = std::max<std::size_t>(
+      16, static_cast<std::size_t>(10 * std::sqrt(static_cast<double>(cols))));
+
+  // elements [0, rows) are rows of A, rows + v is the clique left by
+  // elimination of column v
+  auto num_elems = rows + cols;
+  vector::Vector<vector::Vector<std::size_t>> elem_vars(num_elems);
+  vector::Vector<vector::Vector<std::size_t>> var_elems(cols);
+  vector::Vector<bool> absorbed(num_elems, false);
+  for (std::size_t i = 0; i < rows; ++i) {
+    auto b = row_ptr[i];
+    auto e = row_ptr[i + 1];
+    if (e - b > dense) {
+      continue;
+    }
+    elem_vars[i].append(col_idx + b, col_idx + e);
+    for (auto p = b; p < e; ++p) {
+      var_elems[col_idx[p]].push_back(i);
+    }
+  }
+
+  // (degree, column) pairs of not yet eliminated columns
+  std::set<std::pair<std::size_t, std::size_t>> queue;
+  vector::Vector<std::size_t> degree(cols, 0);
+  for (std::size_t v = 0; v < cols; ++v) {
+    for (auto e : var_elems[v]) {
+      degree[v] += elem_vars[e].size() - 1;
+    }
+    degree[v] = std::min(degree[v], cols - 1);
+    queue.emplace(degree[v], v);
+  }
+
+  vector::Vector<std::size_t> order;
+  order.reserve(cols);
+  vector::Vector<std::size_t> var_mark(cols, 0);
+  vector::Vector<std::size_t> elem_mark(num_elems, 0);
+  vector::Vector<std::size_t> outside(num_elems);
+  for (std::size_t k = 0; k < cols; ++k) {
+    auto pivot = queue.begin()->second;
+    queue.erase(queue.begin());
+    order.push_back(pivot);
+
+    // new element is union of elements of pivot, which are absorbed by it
+    auto stamp = k + 1;
+    auto pivot_elem = rows + pivot;
+    auto& clique = elem_vars[pivot_elem];
+    var_mark[pivot] = stamp;
+    for (auto e : var_elems[pivot]) {
+      if (absorbed[e]) {
+        continue;
+      }
+      for (auto v : elem_vars[e]) {
+        if (var_mark[v] != stamp) {
+          var_mark[v] = stamp;
+          clique.push_back(v);
+        }
+      }
+      absorbed[e] = true;
+      elem_vars[e] = vector::Vector<std::size_t>();
+    }
+    var_elems[pivot] = vector::Vector<std::size_t>();
+
+    // outside[e] = |e \ clique| for elements adjacent to the clique
+    for (auto v : clique) {
+      for (auto e : var_elems[v]) {
+        if (absorbed[e]) {
+          continue;
+        }
+        if (elem_mark[e] != stamp) {
+          elem_mark[e] = stamp;
+          outside[e] = elem_vars[e].size();
+        }
+        --outside[e];
+      }
+    }
+
+    // degree bound: clique plus parts of other elements outside of it
+    auto remaining = cols - k - 1;
+    for (auto v : clique) {
+      auto& elems = var_elems[v];
+      std::size_t deg = clique.size() - 1;
+      std::size_t live = 0;
+      for (auto e : elems) {
+        if (absorbed[e]) {
+          continue;
+        }
+        // element inside the clique carries no extra adjacency
+        if (!outside[e]) {
+          absorbed[e] = true;
+          elem_vars[e] = vector::Vector<std::size_t>();
+          continue;
+        }
+        deg += outside[e];
+        elems[live++] = e;
+      }
+      elems.resize(live);
+      elems.push_back(pivot_elem);
+
+      queue.erase({degree[v], v});
+      degree[v] = std::min(deg, remaining);
+      queue.emplace(degree[v], v);
+    }
+  }
+  return order;
+}
+
+}  // namespace detail
+}  // namespace matrix
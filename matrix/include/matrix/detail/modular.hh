@@ -0,0 +1,206 @@
+/**
+ * Word-sized modular arithmetic for exact determinants.
+ */
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+#include "vector/vector.hh"
+
+/**
+ * FOR INTERNAL PURPOSES ONLY. DO NOT USE IN USER PROGRAM
+ */
+namespace matrix::detail {
+
+using u64 = std::uint64_t;
+// __extension__ keeps -Wpedantic quiet about the non-standard types
+__extension__ typedef unsigned __int128 u128;
+__extension__ typedef __int128 i128;
+
+inline u64 mulMod(u64 a, u64 b, u64 mod) noexcept {
+  return static_cast<u64>(static_cast<u128>(a) * b % mod);
+}
+
+inline u64 powMod(u64 base, u64 exp, u64 mod) noexcept {
+  u64 res = 1 % mod;
+  for (base %= mod; exp; exp >>= 1) {
+    if (exp & 1) {
+      res = mulMod(res, base, mod);
+    }
+    base = mulMod(base, base, mod);
+  }
+  return res;
+}
+
+/** Deterministic Miller-Rabin test for 64-bit numbers */
+inline bool isPrime(u64 n) noexcept {
+  if (n < 2) {
+    return false;
+  }
+
+  constexpr u64 kBases[] = {2, 3, 5, 7, 11, 13, 17, 19, 23, 29, 31, 37};
+  for (auto p : kBases) {
+    if (n % p == 0) {
+      return n == p;
+    }
+  }
+
+  auto d = n - 1;
+  unsigned s = 0;
+  for (; !(d & 1); d >>= 1) {
+    ++s;
+  }
+  for (auto a : kBases) {
+    auto x = powMod(a, d, n);
+    if (x == 1 || x == n - 1) {
+      continue;
+    }
+    auto composite = true;
+    for (unsigned r = 1; r < s && composite; ++r) {
+      x = mulMod(x, x, n);
+      composite = x != n - 1;
+    }
+    if (composite) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/** Largest primes below 2^62 in decreasing order, generated on demand */
+inline const vector::Vector<u64>& modularPrimes(std::size_t count) {
+  thread_local vector::Vector<u64> primes;
+  auto candidate = primes.empty() ? (u64{1} << 62) - 1 : primes.back() - 2;
+  for (; primes.size() < count; candidate -= 2) {
+    if (isPrime(candidate)) {
+      primes.push_back(candidate);
+    }
+  }
+  return primes;
+}
+
+/**
+ * Montgomery form a * 2^64 mod p of residues modulo odd p < 2^62:
+ * products are reduced with two multiplications instead of division.
+ * Values are kept in [0, p).
+ */
+class Montgomery final {
+ public:
+  explicit Montgomery(u64 mod) noexcept : mod_(mod) {
+    // Newton iteration doubles correct low bits of mod^{-1} mod 2^64
+    u64 inv = mod;
+    for (int i = 0; i < 5; ++i) {
+      inv *= 2 - mod * inv;
+    }
+    neg_inv_ = ~inv + 1;
+    r2_ = static_cast<u64>((static_cast<u128>(1) << 64) % mod);
+    r2_ = mulMod(r2_, r2_, mod);
+  }
+
+  u64 mod() const noexcept { return mod_; }
+
+  u64 reduce(u128 t) const noexcept {
+    auto m = static_cast<u64>(t) * neg_inv_;
+    auto res = static_cast<u64>((t + static_cast<u128>(m) * mod_) >> 64);
+    return res >= mod_ ? res - mod_ : res;
+  }
+
+  u64 mul(u64 a, u64 b) const noexcept {
+    return reduce(static_cast<u128>(a) * b);
+  }
+
+  u64 add(u64 a, u64 b) const noexcept {
+    auto res = a + b;
+    return res >= mod_ ? res - mod_ : res;
+  }
+
+  u64 sub(u64 a, u64 b) const noexcept {
+    return a >= b ? a - b : a + mod_ - b;
+  }
+
+  u64 toMont(u64 a) const noexcept { return mul(a % mod_, r2_); }
+  u64 fromMont(u64 a) const noexcept { return reduce(a); }
+
+  /** Inverse of nonzero a by Fermat's little theorem, both in the form */
+  u64 inverse(u64 a) const noexcept {
+    auto res = toMont(1);
+    for (auto exp = mod_ - 2; exp; exp >>= 1) {
+      if (exp & 1) {
+        res = mul(res, a);
+      }
+      a = mul(a, a);
+    }
+    return res;
+  }
+
+ private:
+  u64 mod_;
+  u64 neg_inv_;
+  u64 r2_;  ///< 2^128 mod p, converts into the form
+};
+
+/** Residue of integer modulo p */
+template <typename T>
+u64 residue(T value, u64 mod) noexcept {
+  static_assert(std::is_integral_v<T>);
+  if constexpr (std::is_signed_v<T>) {
+    auto mag = static_cast<u64>(value);
+    if (value < 0) {
+      mag = (~mag + 1) % mod;
+      return mag ? mod - mag : 0;
+    }
+    return mag % mod;
+  } else {
+    return static_cast<u64>(value) % mod;
+  }
+}
+
+/**
+ * Determinant modulo prime by Gaussian elimination over the field,
+ * O(n^3) Montgomery multiplications.
+ * @param work buffer of n * n elements.
+ */
+template <typename T>
+u64 detModPrime(const T* a, std::size_t n, std::size_t lda,
+                const Montgomery& mg, u64* work) {
+  for (std::size_t i = 0; i < n; ++i) {
+    for (std::size_t j = 0; j < n; ++j) {
+      work[i * n + j] = mg.toMont(residue(a[i * lda + j], mg.mod()));
+    }
+  }
+
+  auto det = mg.toMont(1);
+  for (std::size_t k = 0; k < n; ++k) {
+    auto p = k;
+    while (p < n && !work[p * n + k]) {
+      ++p;
+    }
+    if (p == n) {
+      return 0;
+    }
+    auto* pivot_row = work + k * n;
+    if (p != k) {
+      std::swap_ranges(pivot_row + k, pivot_row + n, work + p * n + k);
+      det = mg.sub(0, det);
+    }
+
+    det = mg.mul(det, pivot_row[k]);
+    auto inv = mg.inverse(pivot_row[k]);
+    for (auto i = k + 1; i < n; ++i) {
+      auto* row = work + i * n;
+      if (!row[k]) {
+        continue;
+      }
+      auto coef = mg.mul(row[k], inv);
+      for (auto j = k + 1; j < n; ++j) {
+        row[j] = mg.sub(row[j], mg.mul(coef, pivot_row[j]));
+      }
+    }
+  }
+  return mg.fromMont(det);
+}
+
+}  // namespace matrix::detail
@@ -0,0 +1,220 @@
+/**
+ * Vectorized AXPY kernels (y += alpha * x) with runtime CPU dispatch.
+ */
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+#include <type_traits>
+
+#if (defined(__x86_64__) || defined(__i386__)) && \
+    (defined(__GNUC__) || defined(__clang__))
+#define MATRIX_SIMD_X86 1
+#include <immintrin.h>
+#else
+#define MATRIX_SIMD_X86 0
+#endif
+
+/**
+ * FOR INTERNAL PURPOSES ONLY. DO NOT USE IN USER PROGRAM
+ */
+namespace matrix::detail::simd {
+
+/** Instruction set extensions kernels are specialized for */
+enum class Isa { kScalar, kSse2, kAvx2, kAvx512 };
+
+template <typename T>
+using AxpyKernel = void (*)(T*, const T*, std::size_t, T) noexcept;
+
+template <typename T>
+void axpyScalar(T* y, const T* x, std::size_t n, T alpha) noexcept {
+  for (std::size_t i = 0; i < n; ++i) {
+    y[i] += alpha * x[i];
+  }
+}
+
+#if MATRIX_SIMD_X86
+
+/**
+ * @defgroup SSE2 kernels {
+ */
+__attribute__((target("sse2"))) inline void axpySse2(double* y,
+                                                     const double* x,
+                                                     std::size_t n,
+                                                     double alpha) noexcept {
+  auto a = _mm_set1_pd(alpha);
+  std::size_t i = 0;
+  for (; i + 4 <= n; i += 4) {
+    auto y0 = _mm_add_pd(_mm_loadu_pd(y + i),
+                         _mm_mul_pd(a, _mm_loadu_pd(x + i)));
+    auto y1 = _mm_add_pd(_mm_loadu_pd(y + i + 2),
+                         _mm_mul_pd(a, _mm_loadu_pd(x + i + 2)));
+    _mm_storeu_pd(y + i, y0);
+    _mm_storeu_pd(y + i + 2, y1);
+  }
+  axpyScalar(y + i, x + i, n - i, alpha);
+}
+
+__attribute__((target("sse2"))) inline void axpySse2(float* y, const float* x,
+                                                     std::size_t n,
+                                                     float alpha) noexcept {
+  auto a = _mm_set1_ps(alpha);
+  std::size_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    auto y0 = _mm_add_ps(_mm_loadu_ps(y + i),
+                         _mm_mul_ps(a, _mm_loadu_ps(x + i)));
+    auto y1 = _mm_add_ps(_mm_loadu_ps(y + i + 4),
+                         _mm_mul_ps(a, _mm_loadu_ps(x + i + 4)));
+    _mm_storeu_ps(y + i, y0);
+    _mm_storeu_ps(y + i + 4, y1);
+  }
+  axpyScalar(y + i, x + i, n - i, alpha);
+}
+/** } */
+
+/**
+ * @defgroup AVX2 + FMA kernels {
+ */
+__attribute__((target("avx2,fma"))) inline void axpyAvx2(
+    double* y, const double* x, std::size_t n, double alpha) noexcept {
+  auto a = _mm256_set1_pd(alpha);
+  std::size_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    auto y0 = _mm256_fmadd_pd(a, _mm256_loadu_pd(x + i),
+                              _mm256_loadu_pd(y + i));
+    auto y1 = _mm256_fmadd_pd(a, _mm256_loadu_pd(x + i + 4),
+                              _mm256_loadu_pd(y + i + 4));
+    _mm256_storeu_pd(y + i, y0);
+    _mm256_storeu_pd(y + i + 4, y1);
+  }
+  for (; i < n; ++i) {
+    y[i] = std::fma(alpha, x[i], y[i]);
+  }
+}
+
+__attribute__((target("avx2,fma"))) inline void axpyAvx2(
+    float* y, const float* x, std::size_t n, float alpha) noexcept {
+  auto a = _mm256_set1_ps(alpha);
+  std::size_t i = 0;
+  for (; i + 16 <= n; i += 16) {
+    auto y0 = _mm256_fmadd_ps(a, _mm256_loadu_ps(x + i),
+                              _mm256_loadu_ps(y + i));
+    auto y1 = _mm256_fmadd_ps(a, _mm256_loadu_ps(x + i + 8),
+                              _mm256_loadu_ps(y + i + 8));
+    _mm256_storeu_ps(y + i, y0);
+    _mm256_storeu_ps(y + i + 8, y1);
+  }
+  for (; i < n; ++i) {
+    y[i] = std::fma(alpha, x[i], y[i]);
+  }
+}
+/** } */
+
+/**
+ * @defgroup AVX-512 kernels {
+ */
+__attribute__((target("avx512f"))) inline void axpyAvx512(
+    double* y, const double* x, std::size_t n, double alpha) noexcept {
+  auto a = _mm512_set1_pd(alpha);
+  std::size_t i = 0;
+  for (; i + 16 <= n; i += 16) {
+    auto y0 = _mm512_fmadd_pd(a, _mm512_loadu_pd(x + i),
+                              _mm512_loadu_pd(y + i));
+    auto y1 = _mm512_fmadd_pd(a, _mm512_loadu_pd(x + i + 8),
+                              _mm512_loadu_pd(y + i + 8));
+    _mm512_storeu_pd(y + i, y0);
+    _mm512_storeu_pd(y + i + 8, y1);
+  }
+  for (; i < n; i += 8) {
+    auto rest = n - i;
+    auto mask = static_cast<__mmask8>(rest >= 8 ? 0xff : (1u << rest) - 1);
+    auto y0 = _mm512_fmadd_pd(a, _mm512_maskz_loadu_pd(mask, x + i),
+                              _mm512_maskz_loadu_pd(mask, y + i));
+    _mm512_mask_storeu_pd(y + i, mask, y0);
+  }
+}
+
+__attribute__((target("avx512f"))) inline void axpyAvx512(
+    float* y, const float* x, std::size_t n, float alpha) noexcept {
+  auto a = _mm512_set1_ps(alpha);
+  std::size_t i = 0;
+  for (; i + 32 <= n; i += 32) {
+    auto y0 = _mm512_fmadd_ps(a, _mm512_loadu_ps(x + i),
+                              _mm512_loadu_ps(y + i));
+    auto y1 = _mm512_fmadd_ps(a, _mm512_loadu_ps(x + i + 16),
+                              _mm512_loadu_ps(y + i + 16));
+    _mm512_storeu_ps(y + i, y0);
+    _mm512_storeu_ps(y + i + 16, y1);
+  }
+  for (; i < n; i += 16) {
+    auto rest = n - i;
+    auto mask =
+        static_cast<__mmask16>(rest >= 16 ? 0xffff : (1u << rest) - 1);
+    auto y0 = _mm512_fmadd_ps(a, _mm512_maskz_loadu_ps(mask, x + i),
+                              _mm512_maskz_loadu_ps(mask, y + i));
+    _mm512_mask_storeu_ps(y + i, mask, y0);
+  }
+}
+/** } */
+
+#endif  // MATRIX_SIMD_X86
+
+/** Checks whether current CPU is able to run kernels for given isa */
+inline bool isSupported(Isa isa) noexcept {
+#if MATRIX_SIMD_X86
+  __builtin_cpu_init();
+#endif
+  switch (isa) {
+    case Isa::kScalar:
+      return true;
+#if MATRIX_SIMD_X86
+    case Isa::kSse2:
+      return __builtin_cpu_supports("sse2");
+    case Isa::kAvx2:
+      return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+    case Isa::kAvx512:
+      return __builtin_cpu_supports("avx512f");
+#endif
+    default:
+      return false;
+  }
+}
+
+/** Widest instruction set supported by current CPU */
+inline Isa detectIsa() noexcept {
+  for (auto isa : {Isa::kAvx512, Isa::kAvx2, Isa::kSse2}) {
+    if (isSupported(isa)) {
+      return isa;
+    }
+  }
+  return Isa::kScalar;
+}
+
+/** Returns AXPY kernel for given isa, which must be supported by CPU */
+template <typename T>
+AxpyKernel<T> axpyKernel(Isa isa) noexcept {
+#if MATRIX_SIMD_X86
+  if constexpr (std::is_same_v<T, double> || std::is_same_v<T, float>) {
+    switch (isa) {
+      case Isa::kSse2:
+        return static_cast<AxpyKernel<T>>(&axpySse2);
+      case Isa::kAvx2:
+        return static_cast<AxpyKernel<T>>(&axpyAvx2);
+      case Isa::kAvx512:
+        return static_cast<AxpyKernel<T>>(&axpyAvx512);
+      default:
+        break;
+    }
+  }
+#endif
+  return &axpyScalar<T>;
+}
+
+/** y += alpha * x using the best kernel for current CPU */
+template <typename T>
+void axpy(T* y, const T* x, std::size_t n, T alpha) noexcept {
+  static const auto kernel = axpyKernel<T>(detectIsa());
+  kernel(y, x, n, alpha);
+}
+
+}  // namespace matrix::detail::simd
@@ -0,0 +1,193 @@
+/**
+ * Exact determinant of integer matrices.
+ */
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <type_traits>
+
+#include "big_int.hh"
+#include "detail/modular.hh"
+#include "matrix.hh"
+#include "thread_pool.hh"
+#include "vector/vector.hh"
+
+namespace matrix {
+
+/**
+ * FOR INTERNAL PURPOSES ONLY. DO NOT USE IN USER PROGRAM
+ */
+namespace detail {
+
+/**
+ * log2 of Hadamard bound |det A| <= prod of Euclidean norms of rows,
+ * the smaller of row and column variants. Negative infinity if there
+ * is zero row or column.
+ */
+template <typename T>
+double log2HadamardBound(const T* a, std::size_t n, std::size_t lda) {
+  vector::Vector<long double> col_norms(n, 0);
+  auto rows_log = 0.0L;
+  for (std::size_t i = 0; i < n; ++i) {
+    auto norm = 0.0L;
+    for (std::size_t j = 0; j < n; ++j) {
+      auto v = static_cast<long double>(a[i * lda + j]);
+      norm += v * v;
+      col_norms[j] += v * v;
+    }
+    rows_log += std::log2(norm) / 2;
+  }
+
+  auto cols_log = 0.0L;
+  for (auto norm : col_norms) {
+    cols_log += std::log2(norm) / 2;
+  }
+  return static_cast<double>(std::min(rows_log, cols_log));
+}
+
+/**
+ * Fraction-free Bareiss elimination in 128-bit integers. Intermediate
+ * values are minors, and products of two of them are formed before
+ * exact division, so |det| bound must be below 2^63.
+ */
+template <typename T>
+BigInt bareissDet(const T* a, std::size_t n, std::size_t lda) {
+  vector::Vector<i128> m(n * n, vector::kDefaultInit);
+  for (std::size_t i = 0; i < n; ++i) {
+    for (std::size_t j = 0; j < n; ++j) {
+      m[i * n + j] = static_cast<i128>(a[i * lda + j]);
+    }
+  }
+
+  auto negative = false;
+  i128 prev = 1;
+  for (std::size_t k = 0; k + 1 < n; ++k) {
+    auto p = k;
+    while (p < n && !m[p * n + k]) {
+      ++p;
+    }
+    if (p == n) {
+      return BigInt();
+    }
+    if (p != k) {
+      std::swap_ranges(m.begin() + k * n, m.begin() + (k + 1) * n,
+                       m.begin() + p * n);
+      negative = !negative;
+    }
+
+    auto pivot = m[k * n + k];
+    for (auto i = k + 1; i < n; ++i) {
+      for (auto j = k + 1; j < n; ++j) {
+        m[i * n + j] =
+            (m[i * n + j] * pivot - m[i * n + k] * m[k * n + j]) / prev;
+      }
+    }
+    prev = pivot;
+  }
+
+  auto det = m[n * n - 1];
+  if (det < 0) {
+    negative = !negative;
+  }
+  auto mag = static_cast<u128>(det < 0 ? -det : det);
+  return BigInt::fromParts(negative, static_cast<std::uint64_t>(mag >> 64),
+                           static_cast<std::uint64_t>(mag));
+}
+
+/**
+ * Integer in (-M / 2, M / 2) with given residues, M = prod of primes.
+ * Garner's algorithm finds mixed radix digits x = c0 + c1 * p0 +
+ * c2 * p0 * p1 + ..., digits p_i - 1 - c_i give M - 1 - x, and the
+ * smaller of x and M - x is the magnitude.
+ */
+inline BigInt reconstructCrt(const vector::Vector<u64>& residues,
+                             const u64* primes) {
+  auto k = residues.size();
+  vector::Vector<u64> digits(k, vector::kDefaultInit);
+  for (std::size_t i = 0; i < k; ++i) {
+    // value of the known digits and their radix modulo p
+    auto p = primes[i];
+    u64 value = 0;
+    u64 radix = 1;
+    for (std::size_t j = 0; j < i; ++j) {
+      value = (value + mulMod(digits[j], radix, p)) % p;
+      radix = mulMod(radix, primes[j], p);
+    }
+    auto diff = residues[i] >= value ? residues[i] - value
+                                     : residues[i] + p - value;
+    digits[i] = mulMod(diff, powMod(radix, p - 2, p), p);
+  }
+
+  BigInt pos;
+  BigInt neg;
+  for (auto i = k; i-- > 0;) {
+    pos.mulAdd(primes[i], digits[i]);
+    neg.mulAdd(primes[i], primes[i] - 1 - digits[i]);
+  }
+  neg.mulAdd(1, 1);
+  return BigInt::compareAbs(pos, neg) <= 0 ? pos : -neg;
+}
+
+/**
+ * Exact determinant of n x n integer matrix with leading dimension lda.
+ * Small results are computed by Bareiss elimination. Otherwise
+ * determinant is found modulo enough 62-bit primes for their product to
+ * exceed twice Hadamard bound, in parallel over primes, and restored by
+ * Chinese remaindering.
+ */
+template <typename T>
+BigInt exactDet(const T* a, std::size_t n, std::size_t lda,
+                ThreadPool* pool) {
+  static_assert(std::is_integral_v<T>, "exact determinant requires integers");
+  auto bound = log2HadamardBound(a, n, lda);
+  if (std::isinf(bound)) {
+    return BigInt();
+  }
+
+  if (bound < 62) {
+    return bareissDet(a, n, lda);
+  }
+
+  // each prime contributes more than 61 bits, one more bit for the sign
+  // and one for rounding of the bound
+  auto num_primes = static_cast<std::size_t>(bound + 2) / 61 + 1;
+  const auto* primes = modularPrimes(num_primes).data();
+  vector::Vector<u64> residues(num_primes, vector::kDefaultInit);
+  auto run = [&](std::size_t begin, std::size_t end) {
+    vector::Vector<u64> work(n * n, vector::kDefaultInit);
+    for (auto i = begin; i < end; ++i) {
+      residues[i] = detModPrime(a, n, lda, Montgomery(primes[i]), work.data());
+    }
+  };
+
+  if (pool) {
+    pool->parallelFor(0, num_primes, 1, run);
+  } else {
+    run(0, num_primes);
+  }
+  return reconstructCrt(residues, primes);
+}
+
+}  // namespace detail
+
+template <typename T, typename Layout>
+BigInt Matrix<T, Layout>::exactDet(ThreadPool* pool) const {
+  if (!isSquare()) {
+    throw std::runtime_error("Matrix::exactDet(): rows_ != cols_");
+  }
+
+  if (!rows_) {
+    throw std::runtime_error("Matrix::exactDet(): matrix size must be > 0");
+  }
+
+  if constexpr (Layout::kStrided) {
+    return detail::exactDet(data(), rows_, rows_, pool);
+  } else {
+    return Matrix<T>(*this).exactDet(pool);
+  }
+}
+
+}  // namespace matrix
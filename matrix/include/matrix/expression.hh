@@ -0,0 +1,238 @@
+/**
+ * Expression templates for lazy element-wise matrix arithmetic.
+ *
+ * Operators below build a tree of lightweight nodes instead of computing
+ * intermediate matrices. The tree is evaluated element by element in one
+ * loop when assigned to a Matrix, e.g. A + 2 * B - C makes a single pass
+ * over memory and does not allocate temporaries.
+ *
+ * Nodes refer to matrix operands without owning them, so expression must
+ * be evaluated while operands are alive:
+ *   Matrix<double> d = a + b;  // fine
+ *   auto e = a + b;            // fine while a and b are alive
+ */
+#pragma once
+
+#include <cstddef>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+#include "layout.hh"
+
+namespace matrix {
+
+/**
+ * CRTP base of all expression nodes. Being declared in namespace matrix,
+ * it makes operators below visible for nodes through ADL.
+ */
+template <typename E>
+struct MatrixExpr {
+  const E& self() const noexcept { return static_cast<const E&>(*this); }
+};
+
+/**
+ * FOR INTERNAL PURPOSES ONLY. DO NOT USE IN USER PROGRAM
+ */
+namespace detail {
+
+template <typename T>
+struct IsExprNode : std::is_base_of<MatrixExpr<T>, T> {};
+
+template <typename T>
+struct IsExpr : IsExprNode<T> {};
+
+template <typename T>
+struct IsExpr<Matrix<T>> : std::true_type {};
+
+template <typename T>
+constexpr bool kIsExpr = IsExpr<std::decay_t<T>>::value;
+
+template <typename T>
+constexpr bool kIsExprNode = IsExprNode<std::decay_t<T>>::value;
+
+/** Leaf referring to matrix storage */
+template <typename T>
+class MatrixLeaf : public MatrixExpr<MatrixLeaf<T>> {
+ public:
+  using value_type = T;
+
+  explicit MatrixLeaf(const Matrix<T>& m) noexcept
+      : data_(m.data()), rows_(m.rows()), cols_(m.cols()) {}
+
+  std::size_t rows() const noexcept { return rows_; }
+  std::size_t cols() const noexcept { return cols_; }
+  value_type at(std::size_t idx) const noexcept { return data_[idx]; }
+
+ private:
+  const T* data_;
+  std::size_t rows_;
+  std::size_t cols_;
+};
+
+/** Matrices become leaves, nodes are stored by value */
+template <typename T>
+MatrixLeaf<T> asNode(const Matrix<T>& m) noexcept {
+  return MatrixLeaf<T>(m);
+}
+
+template <typename E, typename = std::enable_if_t<kIsExprNode<E>>>
+const E& asNode(const E& e) noexcept {
+  return e;
+}
+
+template <typename E>
+using NodeOf = std::decay_t<decltype(asNode(std::declval<const E&>()))>;
+
+template <typename L, typename R, typename Op>
+class BinaryExpr : public MatrixExpr<BinaryExpr<L, R, Op>> {
+ public:
+  using value_type = decltype(Op()(std::declval<typename L::value_type>(),
+                                   std::declval<typename R::value_type>()));
+
+  BinaryExpr(const L& lhs, const R& rhs) : lhs_(lhs), rhs_(rhs) {
+    if (lhs_.rows() != rhs_.rows() || lhs_.cols() != rhs_.cols()) {
+      throw std::runtime_error("BinaryExpr: matrix sizes differ");
+    }
+  }
+
+  std::size_t rows() const noexcept { return lhs_.rows(); }
+  std::size_t cols() const noexcept { return lhs_.cols(); }
+  value_type at(std::size_t idx) const noexcept {
+    return Op()(lhs_.at(idx), rhs_.at(idx));
+  }
+
+ private:
+  L lhs_;
+  R rhs_;
+};
+
+/** Element-wise operation with scalar */
+template <typename E, typename S, typename Op>
+class ScalarExpr : public MatrixExpr<ScalarExpr<E, S, Op>> {
+ public:
+  using value_type = decltype(Op()(std::declval<typename E::value_type>(),
+                                   std::declval<S>()));
+
+  ScalarExpr(const E& expr, S scalar) noexcept
+      : expr_(expr), scalar_(scalar) {}
+
+  std::size_t rows() const noexcept { return expr_.rows(); }
+  std::size_t cols() const noexcept { return expr_.cols(); }
+  value_type at(std::size_t idx) const noexcept {
+    return Op()(expr_.at(idx), scalar_);
+  }
+
+ private:
+  E expr_;
+  S scalar_;
+};
+
+template <typename E>
+class NegateExpr : public MatrixExpr<NegateExpr<E>> {
+ public:
+  using value_type = typename E::value_type;
+
+  explicit NegateExpr(const E& expr) noexcept : expr_(expr) {}
+
+  std::size_t rows() const noexcept { return expr_.rows(); }
+  std::size_t cols() const noexcept { return expr_.cols(); }
+  value_type at(std::size_t idx) const noexcept { return -expr_.at(idx); }
+
+ private:
+  E expr_;
+};
+
+/**
+ * @defgroup Operations {
+ */
+struct Plus {
+  template <typename A, typename B>
+  auto operator()(const A& a, const B& b) const noexcept {
+    return a + b;
+  }
+};
+
+struct Minus {
+  template <typename A, typename B>
+  auto operator()(const A& a, const B& b) const noexcept {
+    return a - b;
+  }
+};
+
+struct Multiplies {
+  template <typename A, typename B>
+  auto operator()(const A& a, const B& b) const noexcept {
+    return a * b;
+  }
+};
+
+struct Divides {
+  template <typename A, typename B>
+  auto operator()(const A& a, const B& b) const noexcept {
+    return a / b;
+  }
+};
+/** } */
+
+/**
+ * Evaluates expression into contiguous storage of the same shape
+ * in a single fused loop.
+ */
+template <typename T, typename E>
+void evaluate(T* dst, const E& expr) noexcept {
+  auto sz = expr.rows() * expr.cols();
+  for (std::size_t i = 0; i < sz; ++i) {
+    dst[i] = static_cast<T>(expr.at(i));
+  }
+}
+
+}  // namespace detail
+
+template <typename L, typename R,
+          typename =
+              std::enable_if_t<detail::kIsExpr<L> && detail::kIsExpr<R>>>
+auto operator+(const L& lhs, const R& rhs) {
+  return detail::BinaryExpr<detail::NodeOf<L>, detail::NodeOf<R>,
+                            detail::Plus>(detail::asNode(lhs),
+                                          detail::asNode(rhs));
+}
+
+template <typename L, typename R,
+          typename =
+              std::enable_if_t<detail::kIsExpr<L> && detail::kIsExpr<R>>>
+auto operator-(const L& lhs, const R& rhs) {
+  return detail::BinaryExpr<detail::NodeOf<L>, detail::NodeOf<R>,
+                            detail::Minus>(detail::asNode(lhs),
+                                           detail::asNode(rhs));
+}
+
+template <typename E, typename = std::enable_if_t<detail::kIsExpr<E>>>
+auto operator-(const E& expr) {
+  return detail::NegateExpr<detail::NodeOf<E>>(detail::asNode(expr));
+}
+
+template <typename E, typename S,
+          typename = std::enable_if_t<detail::kIsExpr<E> &&
+                                      std::is_arithmetic_v<S>>>
+auto operator*(const E& expr, S scalar) {
+  return detail::ScalarExpr<detail::NodeOf<E>, S, detail::Multiplies>(
+      detail::asNode(expr), scalar);
+}
+
+template <typename S, typename E,
+          typename = std::enable_if_t<detail::kIsExpr<E> &&
+                                      std::is_arithmetic_v<S>>>
+auto operator*(S scalar, const E& expr) {
+  return expr * scalar;
+}
+
+template <typename E, typename S,
+          typename = std::enable_if_t<detail::kIsExpr<E> &&
+                                      std::is_arithmetic_v<S>>>
+auto operator/(const E& expr, S scalar) {
+  return detail::ScalarExpr<detail::NodeOf<E>, S, detail::Divides>(
+      detail::asNode(expr), scalar);
+}
+
+}  // namespace matrix
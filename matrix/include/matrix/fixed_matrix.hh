@@ -0,0 +1,289 @@
+/**
+ * Matrix with dimensions known at compile time.
+ * Elements are stored inline, all operations are constexpr
+ * and work over compile-time bounds, so compiler unrolls them completely.
+ */
+#pragma once
+
+#include <cstddef>
+#include <initializer_list>
+#include <stdexcept>
+#include <type_traits>
+
+#include "comparator.hh"
+#include "matrix.hh"
+
+namespace matrix {
+
+/**
+ * FOR INTERNAL PURPOSES ONLY. DO NOT USE IN USER PROGRAM
+ */
+namespace detail {
+
+template <typename T>
+constexpr T constexprAbs(T v) noexcept {
+  return v < 0 ? -v : v;
+}
+
+/** Gaussian elimination with partial pivoting over N x N array */
+template <std::size_t N>
+constexpr double eliminationDet(double (&m)[N][N]) noexcept {
+  auto det = 1.0;
+  for (std::size_t k = 0; k < N; ++k) {
+    auto pivot = k;
+    for (auto i = k + 1; i < N; ++i) {
+      if (constexprAbs(m[i][k]) > constexprAbs(m[pivot][k])) {
+        pivot = i;
+      }
+    }
+
+    if (constexprAbs(m[pivot][k]) <= comparator::kAbsTol<double>) {
+      return 0;
+    }
+
+    if (pivot != k) {
+      for (std::size_t j = k; j < N; ++j) {
+        auto tmp = m[k][j];
+        m[k][j] = m[pivot][j];
+        m[pivot][j] = tmp;
+      }
+      det = -det;
+    }
+
+    det *= m[k][k];
+    for (auto i = k + 1; i < N; ++i) {
+      auto coef = m[i][k] / m[k][k];
+      for (auto j = k + 1; j < N; ++j) {
+        m[i][j] -= coef * m[k][j];
+      }
+    }
+  }
+  return det;
+}
+
+}  // namespace detail
+
+template <typename T, std::size_t R, std::size_t C>
+class FixedMatrix final {
+  static_assert(std::is_arithmetic_v<T>);
+  static_assert(R > 0 && C > 0);
+
+ public:  // member types
+  using value_type = T;
+  using size_type = std::size_t;
+  using reference = value_type&;
+  using const_reference = const value_type&;
+  using pointer = value_type*;
+  using const_pointer = const value_type*;
+  using iterator = pointer;
+  using const_iterator = const_pointer;
+
+ public:  // constructors
+  /** Creates zero matrix */
+  constexpr FixedMatrix() noexcept : data_() {}
+
+  /**
+   * Creates and fills matrix with given value. Braces select the list
+   * constructor instead, so FixedMatrix{val} sets only the first element.
+   */
+  constexpr explicit FixedMatrix(const_reference val) noexcept : data_() {
+    for (size_type i = 0; i < R * C; ++i) {
+      data_[i] = val;
+    }
+  }
+
+  /** Creates matrix from row-major list, missing elements are zeroed */
+  constexpr FixedMatrix(std::initializer_list<value_type> ilist) noexcept
+      : data_() {
+    size_type i = 0;
+    for (auto it = ilist.begin(); it != ilist.end() && i < R * C; ++it) {
+      data_[i++] = *it;
+    }
+  }
+
+  explicit FixedMatrix(const Matrix<value_type>& other) : data_() {
+    if (other.rows() != R || other.cols() != C) {
+      throw std::runtime_error("FixedMatrix: dimensions mismatch");
+    }
+    std::copy(other.cbegin(), other.cend(), data_);
+  }
+
+  explicit operator Matrix<value_type>() const {
+    return Matrix<value_type>(R, C, cbegin());
+  }
+
+ public:  // accessors
+  constexpr pointer operator[](size_type pos) noexcept {
+    return data_ + pos * C;
+  }
+  constexpr const_pointer operator[](size_type pos) const noexcept {
+    return data_ + pos * C;
+  }
+
+  static constexpr size_type rows() noexcept { return R; }
+  static constexpr size_type cols() noexcept { return C; }
+  static constexpr bool isSquare() noexcept { return R == C; }
+
+  constexpr pointer data() noexcept { return data_; }
+  constexpr const_pointer data() const noexcept { return data_; }
+
+ public:  // iterators
+  constexpr iterator begin() noexcept { return data_; }
+  constexpr iterator end() noexcept { return data_ + R * C; }
+  constexpr const_iterator cbegin() const noexcept { return data_; }
+  constexpr const_iterator cend() const noexcept { return data_ + R * C; }
+
+ public:  // computing functions
+  /**
+   * Closed forms for sizes up to 4, Gaussian elimination otherwise.
+   * Results within comparator::kAbsTol of zero are returned as exact
+   * zero, as elimination and Matrix::det() do for singular matrices.
+   */
+  constexpr double det() const noexcept {
+    static_assert(R == C, "FixedMatrix::det(): rows != cols");
+    if constexpr (R <= 4) {
+      auto res = closedFormDet();
+      return detail::constexprAbs(res) <= comparator::kAbsTol<double> ? 0.0
+                                                                       : res;
+    } else {
+      double m[R][C] = {};
+      for (size_type i = 0; i < R; ++i) {
+        for (size_type j = 0; j < C; ++j) {
+          m[i][j] = static_cast<double>(data_[i * C + j]);
+        }
+      }
+      return detail::eliminationDet(m);
+    }
+  }
+
+  constexpr FixedMatrix<value_type, C, R> transposed() const noexcept {
+    FixedMatrix<value_type, C, R> res;
+    for (size_type i = 0; i < R; ++i) {
+      for (size_type j = 0; j < C; ++j) {
+        res[j][i] = data_[i * C + j];
+      }
+    }
+    return res;
+  }
+
+ public:  // arithmetic
+  constexpr FixedMatrix& operator+=(const FixedMatrix& rhs) noexcept {
+    for (size_type i = 0; i < R * C; ++i) {
+      data_[i] += rhs.data_[i];
+    }
+    return *this;
+  }
+
+  constexpr FixedMatrix& operator-=(const FixedMatrix& rhs) noexcept {
+    for (size_type i = 0; i < R * C; ++i) {
+      data_[i] -= rhs.data_[i];
+    }
+    return *this;
+  }
+
+  constexpr FixedMatrix& operator*=(const_reference scalar) noexcept {
+    for (size_type i = 0; i < R * C; ++i) {
+      data_[i] *= scalar;
+    }
+    return *this;
+  }
+
+  friend constexpr FixedMatrix operator+(FixedMatrix lhs,
+                                         const FixedMatrix& rhs) noexcept {
+    return lhs += rhs;
+  }
+
+  friend constexpr FixedMatrix operator-(FixedMatrix lhs,
+                                         const FixedMatrix& rhs) noexcept {
+    return lhs -= rhs;
+  }
+
+  friend constexpr FixedMatrix operator*(FixedMatrix lhs,
+                                         const_reference scalar) noexcept {
+    return lhs *= scalar;
+  }
+
+  friend constexpr FixedMatrix operator*(const_reference scalar,
+                                         FixedMatrix rhs) noexcept {
+    return rhs *= scalar;
+  }
+
+  template <std::size_t K>
+  friend constexpr FixedMatrix<value_type, R, K> operator*(
+      const FixedMatrix& lhs,
+      const FixedMatrix<value_type, C, K>& rhs) noexcept {
+    FixedMatrix<value_type, R, K> res;
+    for (size_type i = 0; i < R; ++i) {
+      for (size_type k = 0; k < C; ++k) {
+        auto coef = lhs[i][k];
+        for (size_type j = 0; j < K; ++j) {
+          res[i][j] += coef * rhs[k][j];
+        }
+      }
+    }
+    return res;
+  }
+
+  friend constexpr bool operator==(const FixedMatrix& lhs,
+                                   const FixedMatrix& rhs) noexcept {
+    for (size_type i = 0; i < R * C; ++i) {
+      if (lhs.data_[i] != rhs.data_[i]) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  friend constexpr bool operator!=(const FixedMatrix& lhs,
+                                   const FixedMatrix& rhs) noexcept {
+    return !(lhs == rhs);
+  }
+
+ public:  // static functions
+  /** Creates eye matrix */
+  static constexpr FixedMatrix eye() noexcept {
+    static_assert(R == C);
+    FixedMatrix m;
+    for (size_type i = 0; i < R; ++i) {
+      m[i][i] = static_cast<value_type>(1);
+    }
+    return m;
+  }
+
+ private:
+  /** Determinant of matrix of size up to 4, not rounded to zero */
+  constexpr double closedFormDet() const noexcept {
+    auto a = [this](size_type i, size_type j) {
+      return static_cast<double>(data_[i * C + j]);
+    };
+
+    if constexpr (R == 1) {
+      return a(0, 0);
+    } else if constexpr (R == 2) {
+      return a(0, 0) * a(1, 1) - a(0, 1) * a(1, 0);
+    } else if constexpr (R == 3) {
+      return a(0, 0) * (a(1, 1) * a(2, 2) - a(1, 2) * a(2, 1)) -
+             a(0, 1) * (a(1, 0) * a(2, 2) - a(1, 2) * a(2, 0)) +
+             a(0, 2) * (a(1, 0) * a(2, 1) - a(1, 1) * a(2, 0));
+    } else if constexpr (R == 4) {
+      // Laplace expansion by complementary 2x2 minors
+      auto s0 = a(0, 0) * a(1, 1) - a(1, 0) * a(0, 1);
+      auto s1 = a(0, 0) * a(1, 2) - a(1, 0) * a(0, 2);
+      auto s2 = a(0, 0) * a(1, 3) - a(1, 0) * a(0, 3);
+      auto s3 = a(0, 1) * a(1, 2) - a(1, 1) * a(0, 2);
+      auto s4 = a(0, 1) * a(1, 3) - a(1, 1) * a(0, 3);
+      auto s5 = a(0, 2) * a(1, 3) - a(1, 2) * a(0, 3);
+      auto c5 = a(2, 2) * a(3, 3) - a(3, 2) * a(2, 3);
+      auto c4 = a(2, 1) * a(3, 3) - a(3, 1) * a(2, 3);
+      auto c3 = a(2, 1) * a(3, 2) - a(3, 1) * a(2, 2);
+      auto c2 = a(2, 0) * a(3, 3) - a(3, 0) * a(2, 3);
+      auto c1 = a(2, 0) * a(3, 2) - a(3, 0) * a(2, 2);
+      auto c0 = a(2, 0) * a(3, 1) - a(3, 0) * a(2, 1);
+      return s0 * c5 - s1 * c4 + s2 * c3 + s3 * c2 - s4 * c1 + s5 * c0;
+    }
+  }
+
+  value_type data_[R * C];
+};
+
+}  // namespace matrix
@@ -0,0 +1,133 @@
+/**
+ * Storage layout policies of Matrix.
+ */
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+
+namespace matrix {
+
+/**
+ * Layout maps element (i, j) of rows x cols matrix to its offset in
+ * storage of storageSize(rows, cols) elements. Strided layouts also give
+ * row and column strides, so that views and GEMM address them directly.
+ */
+struct RowMajor {
+  static constexpr bool kStrided = true;
+
+  static constexpr std::size_t storageSize(std::size_t rows,
+                                           std::size_t cols) noexcept {
+    return rows * cols;
+  }
+
+  static constexpr std::size_t offset(std::size_t i, std::size_t j,
+                                      std::size_t /*rows*/,
+                                      std::size_t cols) noexcept {
+    return i * cols + j;
+  }
+
+  static constexpr std::size_t rowStride(std::size_t /*rows*/,
+                                         std::size_t cols) noexcept {
+    return cols;
+  }
+
+  static constexpr std::size_t colStride(std::size_t /*rows*/,
+                                         std::size_t /*cols*/) noexcept {
+    return 1;
+  }
+};
+
+/** Columns are contiguous: storage is row-major transpose */
+struct ColMajor {
+  static constexpr bool kStrided = true;
+
+  static constexpr std::size_t storageSize(std::size_t rows,
+                                           std::size_t cols) noexcept {
+    return rows * cols;
+  }
+
+  static constexpr std::size_t offset(std::size_t i, std::size_t j,
+                                      std::size_t rows,
+                                      std::size_t /*cols*/) noexcept {
+    return j * rows + i;
+  }
+
+  static constexpr std::size_t rowStride(std::size_t /*rows*/,
+                                         std::size_t /*cols*/) noexcept {
+    return 1;
+  }
+
+  static constexpr std::size_t colStride(std::size_t rows,
+                                         std::size_t /*cols*/) noexcept {
+    return rows;
+  }
+};
+
+/**
+ * Matrix is split into Tile x Tile blocks stored one after another in
+ * row-major order of blocks, each block row-major inside. A block of
+ * doubles with default Tile is 8 KiB and fits L1 cache, so both its rows
+ * and columns are cheap to walk. Edge blocks are padded to full size.
+ */
+template <std::size_t Tile = 32>
+struct TileMajor {
+  static_assert(Tile && !(Tile & (Tile - 1)), "Tile must be power of two");
+
+  static constexpr bool kStrided = false;
+  static constexpr std::size_t kTile = Tile;
+
+  static constexpr std::size_t padded(std::size_t n) noexcept {
+    return (n + Tile - 1) / Tile * Tile;
+  }
+
+  static constexpr std::size_t storageSize(std::size_t rows,
+                                           std::size_t cols) noexcept {
+    return padded(rows) * padded(cols);
+  }
+
+  static constexpr std::size_t offset(std::size_t i, std::size_t j,
+                                      std::size_t /*rows*/,
+                                      std::size_t cols) noexcept {
+    auto tile = (i / Tile) * (padded(cols) / Tile) + j / Tile;
+    return tile * Tile * Tile + (i % Tile) * Tile + j % Tile;
+  }
+};
+
+template <typename T, typename Layout = RowMajor>
+class Matrix;
+
+/**
+ * FOR INTERNAL PURPOSES ONLY. DO NOT USE IN USER PROGRAM
+ */
+namespace detail {
+
+constexpr std::size_t kConvertBlock = 32;
+
+/**
+ * Copies elements between matrices of different layouts. Both are
+ * walked by kConvertBlock x kConvertBlock blocks, so that cache lines of
+ * either storage are used up before eviction, as in blocked transpose.
+ * Blocks coincide with tiles of default TileMajor.
+ */
+template <typename Src, typename Dst>
+void convertLayout(const Src& src, Dst& dst) {
+  using Elem = typename Dst::value_type;
+  auto rows = src.rows();
+  auto cols = src.cols();
+  for (std::size_t ib = 0; ib < rows; ib += kConvertBlock) {
+    auto ie = std::min(rows, ib + kConvertBlock);
+    for (std::size_t jb = 0; jb < cols; jb += kConvertBlock) {
+      auto je = std::min(cols, jb + kConvertBlock);
+      for (auto i = ib; i < ie; ++i) {
+        for (auto j = jb; j < je; ++j) {
+          dst(i, j) = static_cast<Elem>(src(i, j));
+        }
+      }
+    }
+  }
+}
+
+}  // namespace detail
+
+}  // namespace matrix
@@ -0,0 +1,204 @@
+/**
+ * Persistent LU factorization with partial pivoting.
+ */
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+#include "comparator.hh"
+#include "detail/simd_kernels.hh"
+#include "matrix.hh"
+#include "vector/vector.hh"
+
+namespace matrix {
+
+/**
+ * Keeps packed factors of P * A = L * U and the pivot sequence,
+ * so that determinant, solutions, inverse and rank reuse the single
+ * O(n^3) factorization.
+ */
+template <typename T>
+class Lu final {
+  static_assert(std::is_floating_point_v<T>,
+                "LU factorization requires floating point matrix");
+
+ public:  // member types
+  using value_type = T;
+  using size_type = std::size_t;
+
+ public:  // constructors
+  /** Factors matrix in place reusing its storage */
+  explicit Lu(Matrix<T>&& m, const LuOptions& opts = LuOptions())
+      : lu_(std::move(m)) {
+    if (!lu_.isSquare()) {
+      throw std::runtime_error("Lu::Lu(): rows != cols");
+    }
+
+    if (!lu_.rows()) {
+      throw std::runtime_error("Lu::Lu(): matrix size must be > 0");
+    }
+
+    nonsingular_ = lu_.luFactorize(perm_, opts);
+    det_ = 0;
+    if (nonsingular_) {
+      det_ = 1;
+      for (size_type i = 0; i < size(); ++i) {
+        if (perm_[i] != i) {
+          det_ = -det_;
+        }
+        det_ *= lu_[i][i];
+      }
+    }
+  }
+
+ public:  // accessors
+  size_type size() const noexcept { return lu_.rows(); }
+  bool isSingular() const noexcept { return !nonsingular_; }
+
+  /** Packed factors: L below diagonal (unit diagonal implied), U above */
+  const Matrix<T>& packed() const noexcept { return lu_; }
+
+  /** At step i row i was swapped with row pivots()[i] */
+  const vector::Vector<size_type>& pivots() const noexcept { return perm_; }
+
+  Matrix<T> lower() const {
+    auto n = size();
+    auto l = Matrix<T>::eye(n);
+    for (size_type i = 0; i < n; ++i) {
+      std::copy_n(lu_[i].cbegin(), i, l[i].begin());
+    }
+    return l;
+  }
+
+  Matrix<T> upper() const {
+    auto n = size();
+    Matrix<T> u(n, n);
+    for (size_type i = 0; i < n; ++i) {
+      std::copy(lu_[i].cbegin() + i, lu_[i].cend(), u[i].begin() + i);
+    }
+    return u;
+  }
+
+ public:  // computing functions
+  /** O(1): computed together with factorization */
+  double det() const noexcept { return det_; }
+
+  /** Solves A * x = b in O(n^2) */
+  vector::Vector<T> solve(const vector::Vector<T>& b) const {
+    if (b.size() != size()) {
+      throw std::runtime_error("Lu::solve(): b.size() != size()");
+    }
+
+    Matrix<T> x(size(), 1, b.cbegin());
+    solveInPlace(x);
+    return vector::Vector<T>(x.cbegin(), x.cend());
+  }
+
+  /** Solves A * X = B for all columns of B at once */
+  Matrix<T> solve(Matrix<T> b) const {
+    if (b.rows() != size()) {
+      throw std::runtime_error("Lu::solve(): b.rows() != size()");
+    }
+
+    solveInPlace(b);
+    return b;
+  }
+
+  Matrix<T> inverse() const { return solve(Matrix<T>::eye(size())); }
+
+  /**
+   * Rank equals rank of U since L and P are invertible. Nonsingular case
+   * is O(1), otherwise U is reduced to row echelon form.
+   */
+  size_type rank() const {
+    if (nonsingular_) {
+      return size();
+    }
+
+    auto u = upper();
+    auto n = size();
+    size_type r = 0;
+    for (size_type c = 0; c < n && r < n; ++c) {
+      auto p = r;
+      for (auto i = r + 1; i < n; ++i) {
+        if (std::abs(u[i][c]) > std::abs(u[p][c])) {
+          p = i;
+        }
+      }
+
+      if (comparator::isClose(u[p][c], static_cast<T>(0))) {
+        continue;
+      }
+
+      u.swapRows(r, p);
+      auto* base = u.data() + r * n;
+      for (auto i = r + 1; i < n; ++i) {
+        auto* row = u.data() + i * n;
+        detail::simd::axpy(row + c, base + c, n - c, -row[c] / base[c]);
+      }
+      ++r;
+    }
+    return r;
+  }
+
+ private:
+  void solveInPlace(Matrix<T>& b) const {
+    if (!nonsingular_) {
+      throw std::runtime_error("Lu::solve(): matrix is singular");
+    }
+
+    auto n = size();
+    auto k = b.cols();
+    for (size_type i = 0; i < n; ++i) {
+      b.swapRows(i, perm_[i]);
+    }
+
+    // forward substitution with unit L
+    for (size_type i = 0; i < n; ++i) {
+      auto* row = b.data() + i * k;
+      for (size_type j = 0; j < i; ++j) {
+        detail::simd::axpy(row, b.data() + j * k, k, -lu_[i][j]);
+      }
+    }
+
+    // backward substitution with U
+    for (auto i = n; i-- > 0;) {
+      auto* row = b.data() + i * k;
+      for (auto j = i + 1; j < n; ++j) {
+        detail::simd::axpy(row, b.data() + j * k, k, -lu_[i][j]);
+      }
+      auto inv = 1 / lu_[i][i];
+      std::for_each(row, row + k, [inv](auto& v) { v *= inv; });
+    }
+  }
+
+ private:
+  Matrix<T> lu_;
+  vector::Vector<size_type> perm_;
+  double det_;
+  bool nonsingular_;
+};
+
+template <typename T, typename Layout>
+Lu<detail::FactorType<T>> Matrix<T, Layout>::lu(
+    const LuOptions& opts) const& {
+  return Lu<detail::FactorType<T>>(Matrix<detail::FactorType<T>>(*this),
+                                   opts);
+}
+
+template <typename T, typename Layout>
+Lu<detail::FactorType<T>> Matrix<T, Layout>::lu(const LuOptions& opts) && {
+  if constexpr (std::is_same_v<T, detail::FactorType<T>> && kRowMajor) {
+    return Lu<T>(std::move(*this), opts);
+  } else {
+    return Lu<detail::FactorType<T>>(Matrix<detail::FactorType<T>>(*this),
+                                     opts);
+  }
+}
+
+}  // namespace matrix
@@ -11,20 +11,226 @@
 #include <type_traits>
 
 #include "comparator.hh"
+#include "detail/band_lu.hh"
+#include "detail/gemm.hh"
+#include "detail/lu_kernels.hh"
+#include "expression.hh"
+#include "layout.hh"
+#include "structure.hh"
+#include "thread_pool.hh"
+#include "vector/aligned_allocator.hh"
+#include "vector/stats.hh"
 #include "vector/vector.hh"
+#include "workspace.hh"
 
 namespace matrix {
 
+/** Dense LU factorization algorithm */
+enum class LuAlgorithm {
+  kBlocked,    ///< right-looking, panels of block_size columns
+  kRecursive,  ///< cache-oblivious, block_size is ignored
+};
+
+/** Tunables of LU factorization */
+struct LuOptions {
+  std::size_t block_size = detail::kDefaultLuBlockSize;  ///< panel width
+  ThreadPool* pool = nullptr;  ///< runs serially if not set
+  Workspace* workspace = nullptr;  ///< Workspace::threadLocal() if not set
+  bool detect_structure = true;  ///< see denseDet()
+  LuAlgorithm algorithm = LuAlgorithm::kBlocked;
+};
+
+/**
+ * FOR INTERNAL PURPOSES ONLY. DO NOT USE IN USER PROGRAM
+ */
+namespace detail {
+
+/** Runs LU factorization algorithm chosen by opts */
+template <typename T>
+bool luFactorize(T* a, std::size_t n, std::size_t lda, std::size_t* piv,
+                 const LuOptions& opts) {
+  vector::stats::addFlops(2.0 / 3 * n * n * n);
+  if (opts.algorithm == LuAlgorithm::kRecursive) {
+    return luFactorizeRecursive(a, n, lda, piv, opts.pool);
+  }
+  return luFactorize(a, n, lda, piv, opts.block_size, opts.pool);
+}
+
+/**
+ * Determinant by blocked LU of n x n row-major matrix with leading
+ * dimension lda. Input is left intact, factorization runs over a working
+ * copy whose rows are padded to start at cache line boundary.
+ */
+template <typename T>
+double luDet(const T* a, std::size_t n, std::size_t lda,
+             const LuOptions& opts) {
+  auto ld = paddedStride<double>(n);
+  auto& ws = opts.workspace ? *opts.workspace : Workspace::threadLocal();
+  auto* work = ws.matrix(n, ld);
+  auto* perm = ws.pivots(n);
+  {
+    vector::stats::ScopedPhase phase(vector::stats::Phase::kConvert);
+    for (std::size_t i = 0; i < n; ++i) {
+      std::copy_n(a + i * lda, n, work + i * ld);
+    }
+  }
+
+  if (!luFactorize(work, n, ld, perm, opts)) {
+    return 0;
+  }
+
+  auto det = 1.0;
+  for (std::size_t i = 0; i < n; ++i) {
+    if (perm[i] != i) {
+      det = -det;
+    }
+    auto elem = work[i * ld + i];
+    assert(std::isfinite(elem));
+    det *= elem;
+  }
+  return det;
+}
+
+template <typename T>
+double denseDet(const T* a, std::size_t n, std::size_t lda,
+                const LuOptions& opts);
+
+/**
+ * Product of determinants of diagonal blocks. With pool, a block taking
+ * more than 1 / pool->size() of total O(m^3) work would leave other
+ * threads idle in a parallel loop, so such blocks are factorized one by
+ * one with parallel LU over the whole pool. The rest are factorized in
+ * parallel, each one serially.
+ */
+template <typename T>
+double blockDiagonalDet(const T* a, std::size_t lda, const Structure& s,
+                        const LuOptions& opts) {
+  auto num_blocks = s.numBlocks();
+  vector::Vector<double> dets(num_blocks, vector::kDefaultInit);
+  auto run = [&](std::size_t b, const LuOptions& block_opts) {
+    auto offset = s.blocks[b];
+    dets[b] = denseDet(a + offset * lda + offset, s.blocks[b + 1] - offset,
+                       lda, block_opts);
+  };
+
+  if (opts.pool) {
+    auto work = [&](std::size_t b) {
+      auto size = static_cast<double>(s.blocks[b + 1] - s.blocks[b]);
+      return size * size * size;
+    };
+    auto total = 0.0;
+    for (std::size_t b = 0; b < num_blocks; ++b) {
+      total += work(b);
+    }
+
+    vector::Vector<std::size_t> small;
+    for (std::size_t b = 0; b < num_blocks; ++b) {
+      if (work(b) * opts.pool->size() > total) {
+        run(b, opts);
+      } else {
+        small.push_back(b);
+      }
+    }
+
+    // each small block runs serially on workspace of its thread
+    auto block_opts = opts;
+    block_opts.pool = nullptr;
+    block_opts.workspace = nullptr;
+    opts.pool->parallelFor(0, small.size(), 1,
+                           [&](std::size_t begin, std::size_t end) {
+                             for (auto i = begin; i < end; ++i) {
+                               run(small[i], block_opts);
+                             }
+                           });
+  } else {
+    for (std::size_t b = 0; b < num_blocks; ++b) {
+      run(b, opts);
+    }
+  }
+
+  auto det = 1.0;
+  for (auto d : dets) {
+    det *= d;
+  }
+  return det;
+}
+
+/**
+ * Determinant of n x n row-major matrix with leading dimension lda.
+ * Unless disabled in opts, O(n^2) structure analysis goes first:
+ * triangular matrices take O(n) product of diagonal, block diagonal ones
+ * are split into independent blocks, banded ones take band LU in
+ * O(n * b^2). Other matrices take blocked LU.
+ */
 template <typename T>
+double denseDet(const T* a, std::size_t n, std::size_t lda,
+                const LuOptions& opts) {
+  if (!opts.detect_structure) {
+    return luDet(a, n, lda, opts);
+  }
+
+  auto s = analyzeStructure(a, n, lda);
+  if (s.has_zero_row) {
+    return 0;
+  }
+
+  if (s.isTriangular()) {
+    auto det = 1.0;
+    for (std::size_t i = 0; i < n; ++i) {
+      auto elem = static_cast<double>(a[i * lda + i]);
+      if (comparator::isClose(elem, 0.0)) {
+        return 0;
+      }
+      det *= elem;
+    }
+    return det;
+  }
+
+  if (s.isBlockDiagonal()) {
+    return blockDiagonalDet(a, lda, s, opts);
+  }
+
+  if (s.isBanded()) {
+    auto& ws = opts.workspace ? *opts.workspace : Workspace::threadLocal();
+    auto w = s.bandStorageWidth();
+    return bandDet(a, n, lda, s.lower_bandwidth, s.upper_bandwidth,
+                   ws.matrix(n, w));
+  }
+
+  return luDet(a, n, lda, opts);
+}
+
+}  // namespace detail
+
+template <typename T>
+class Lu;
+
+class BigInt;
+
+/**
+ * Dense matrix. Layout policy (see layout.hh) maps elements to storage:
+ * RowMajor suits row elimination and is the only one supported by row
+ * proxies, element-wise expressions and in-place factorization.
+ * ColMajor and TileMajor matrices convert to each other and to RowMajor
+ * by cache-blocked copies, and computing functions pick a kernel that
+ * matches their storage.
+ */
+template <typename T, typename Layout>
 class Matrix final {
   static_assert(std::is_arithmetic_v<T>);
 
+  static constexpr bool kRowMajor = std::is_same_v<Layout, RowMajor>;
+
   // Contigious storage chosen here because of
   // 1. Positive attitude to cache effects.
   // 2. Less dynamic memory allocations.
   // 3. Less indirections.
+  // Storage is aligned to cache line to allow aligned vector loads.
+  // Matrices up to 4x4 keep elements inline and do not allocate.
+  static constexpr std::size_t kInlineElems = 16;
   using ContigiousContainer =
-      typename vector::Vector<T>;  ///< stores matrix data
+      vector::SmallVector<T, kInlineElems,
+                          vector::AlignedAllocator<T>>;  ///< stores matrix data
 
  public:  // member types
   using iterator = typename ContigiousContainer::iterator;
@@ -36,30 +242,78 @@ class Matrix final {
   using reference = typename ContigiousContainer::reference;
   using const_reference = typename ContigiousContainer::const_reference;
   using pointer = typename ContigiousContainer::pointer;
+  using const_pointer = typename ContigiousContainer::const_pointer;
   using difference_type = typename ContigiousContainer::difference_type;
   using size_type = typename ContigiousContainer::size_type;
+  using layout_type = Layout;
 
  public:  // constructors
   /** Creates and fills matrix with given value */
   explicit Matrix(size_type rows = 0, size_type cols = 0,
                   const_reference val = value_type())
-      : data_(rows * cols, val), rows_(rows), cols_(cols) {}
+      : data_(Layout::storageSize(rows, cols), val),
+        rows_(rows),
+        cols_(cols) {}
 
-  /** Creates matrix from given sequence */
+  /** Creates matrix from given sequence of elements in row-major order */
   template <typename It,
             typename = std::enable_if_t<std::is_base_of_v<
                 std::input_iterator_tag,
                 typename std::iterator_traits<It>::iterator_category>>>
-  Matrix(size_type rows, size_type cols, It begin) : rows_(rows), cols_(cols) {
-    auto sz = rows_ * cols_;
-    data_.reserve(sz);
-    std::copy_n(begin, sz, std::back_inserter(data_));
+  Matrix(size_type rows, size_type cols, It begin)
+      : Matrix(rows, cols, vector::kDefaultInit) {
+    if constexpr (kRowMajor) {
+      std::copy_n(begin, rows_ * cols_, data_.begin());
+    } else {
+      zeroPadding();
+      for (size_type i = 0; i < rows_; ++i) {
+        for (size_type j = 0; j < cols_; ++j, ++begin) {
+          (*this)(i, j) = *begin;
+        }
+      }
+    }
+  }
+
+  /** Creates matrix with uninitialized elements to be overwritten */
+  Matrix(size_type rows, size_type cols, vector::DefaultInit)
+      : data_(Layout::storageSize(rows, cols), vector::kDefaultInit),
+        rows_(rows),
+        cols_(cols) {}
+
+  /** Converts element type and layout */
+  template <typename U, typename OtherLayout>
+  Matrix(const Matrix<U, OtherLayout>& other)
+      : Matrix(other.rows(), other.cols(), vector::kDefaultInit) {
+    if constexpr (std::is_same_v<Layout, OtherLayout>) {
+      std::copy(other.cbegin(), other.cend(), data_.begin());
+    } else {
+      zeroPadding();
+      detail::convertLayout(other, *this);
+    }
+  }
+
+  /** Evaluates element-wise expression, see expression.hh */
+  template <typename E, typename = std::enable_if_t<detail::kIsExprNode<E>>>
+  Matrix(const E& expr)
+      : data_(expr.rows() * expr.cols(), vector::kDefaultInit),
+        rows_(expr.rows()),
+        cols_(expr.cols()) {
+    static_assert(kRowMajor, "expressions are evaluated in row-major order");
+    detail::evaluate(data(), expr);
   }
 
-  template <typename U>
-  Matrix(const Matrix<U>& other) : rows_(other.rows()), cols_(other.cols()) {
-    data_.reserve(rows_ * cols_);
-    std::copy(other.cbegin(), other.cend(), std::back_inserter(data_));
+  template <typename E, typename = std::enable_if_t<detail::kIsExprNode<E>>>
+  Matrix& operator=(const E& expr) {
+    static_assert(kRowMajor, "expressions are evaluated in row-major order");
+    // operands of the same shape as *this are never reallocated here,
+    // so evaluation in place is safe
+    if (rows_ != expr.rows() || cols_ != expr.cols()) {
+      rows_ = expr.rows();
+      cols_ = expr.cols();
+      data_.resize(rows_ * cols_, vector::kDefaultInit);
+    }
+    detail::evaluate(data(), expr);
+    return *this;
   }
 
  private:
@@ -75,19 +329,19 @@ class Matrix final {
     ProxyRowBase(StoredIterator p, size_type cols) noexcept
         : begin_(p), cols_(cols) {}
 
-    template <typename = std::enable_if_t<!IsConst>>
+    template <bool C = IsConst, typename = std::enable_if_t<!C>>
     reference operator[](size_type pos) {
       return begin_[pos];
     }
 
     const_reference operator[](size_type pos) const { return begin_[pos]; }
 
-    template <typename = std::enable_if_t<!IsConst>>
+    template <bool C = IsConst, typename = std::enable_if_t<!C>>
     StoredIterator begin() {
       return begin_;
     }
 
-    template <typename = std::enable_if_t<!IsConst>>
+    template <bool C = IsConst, typename = std::enable_if_t<!C>>
     StoredIterator end() {
       return begin_ + cols_;
     }
@@ -102,21 +356,32 @@ class Matrix final {
 
  public:  // accessors
   ProxyRow operator[](size_type pos) noexcept {
+    static_assert(kRowMajor, "rows are contiguous in RowMajor layout only");
     return ProxyRow(data_.begin() + pos * cols_, cols_);
   }
 
   ConstProxyRow operator[](size_type pos) const noexcept {
+    static_assert(kRowMajor, "rows are contiguous in RowMajor layout only");
     return ConstProxyRow(data_.cbegin() + pos * cols_, cols_);
   }
 
+  reference operator()(size_type row, size_type col) noexcept {
+    return data_[Layout::offset(row, col, rows_, cols_)];
+  }
+
+  const_reference operator()(size_type row, size_type col) const noexcept {
+    return data_[Layout::offset(row, col, rows_, cols_)];
+  }
+
   size_type rows() const noexcept { return rows_; }
   size_type cols() const noexcept { return cols_; }
   pointer data() noexcept { return data_.data(); }
-  const pointer data() const noexcept { return data_.data(); }
+  const_pointer data() const noexcept { return data_.data(); }
 
   bool isSquare() const noexcept { return rows_ == cols_; }
 
  public:  // iterators
+  // iterate over storage in its order, including padding of TileMajor
   iterator begin() noexcept { return data_.begin(); }
   iterator end() noexcept { return data_.end(); }
   const_iterator cbegin() const noexcept { return data_.cbegin(); }
@@ -127,11 +392,32 @@ class Matrix final {
   const_reverse_iterator crbegin() const noexcept { return data_.crbegin(); }
   const_reverse_iterator crend() const noexcept { return data_.crend(); }
 
+ public:  // arithmetic
+  template <typename E, typename = std::enable_if_t<detail::kIsExpr<E>>>
+  Matrix& operator+=(const E& expr) {
+    return *this = *this + expr;
+  }
+
+  template <typename E, typename = std::enable_if_t<detail::kIsExpr<E>>>
+  Matrix& operator-=(const E& expr) {
+    return *this = *this - expr;
+  }
+
+  template <typename S, typename = std::enable_if_t<std::is_arithmetic_v<S>>>
+  Matrix& operator*=(S scalar) {
+    return *this = *this * scalar;
+  }
+
+  template <typename S, typename = std::enable_if_t<std::is_arithmetic_v<S>>>
+  Matrix& operator/=(S scalar) {
+    return *this = *this / scalar;
+  }
+
  public:  // modifiers
   void resize(size_type new_rows, size_type new_cols) {
     rows_ = new_rows;
     cols_ = new_cols;
-    data_.resize(rows_ * cols_);
+    data_.resize(Layout::storageSize(rows_, cols_));
   }
 
   void setRows(size_type new_rows) { resize(new_rows, cols_); }
@@ -141,31 +427,86 @@ class Matrix final {
     if (a == b) {
       return false;
     }
-    auto arow = operator[](a);
-    std::swap_ranges(arow.begin(), arow.end(), operator[](b).begin());
+    vector::stats::ScopedPhase phase(vector::stats::Phase::kRowSwap);
+    if constexpr (kRowMajor) {
+      auto arow = operator[](a);
+      std::swap_ranges(arow.begin(), arow.end(), operator[](b).begin());
+    } else {
+      for (size_type j = 0; j < cols_; ++j) {
+        std::swap((*this)(a, j), (*this)(b, j));
+      }
+    }
     return true;
   }
 
-  // currently supports only floating point calculations
-  void simplifyRows(size_type idx) {
-    auto base_row = operator[](idx);
+  /**
+   * Eliminates column idx below row idx with row idx, currently supports
+   * only floating point calculations. Pivot for the next step is found
+   * in the same pass over the rows, without strided column scan.
+   * @return row of max |element| of column idx + 1 among rows below idx,
+   * rows() if there are none.
+   */
+  size_type simplifyRows(size_type idx) {
+    static_assert(kRowMajor, "row elimination requires RowMajor layout");
+    auto* base_row = data() + idx * cols_;
     auto base_elem = base_row[idx];
     assert(!comparator::isClose(base_elem, static_cast<value_type>(0)));
-    auto base_row_begin = base_row.begin();
-    auto base_row_end = base_row.end();
 
-    for (auto j = idx + 1; j < rows_; ++j) {
-      auto cur_row = operator[](j);
-      auto cur_row_begin = cur_row.begin();
+    vector::stats::ScopedPhase phase(vector::stats::Phase::kElimination);
+    vector::stats::addFlops(2.0 * (rows_ - idx - 1) * cols_);
+    auto next = idx + 1;
+    auto track = next < cols_;
+    auto pivot = rows_;
+    auto max = value_type();
+    for (auto j = next; j < rows_; ++j) {
+      auto* cur_row = data() + j * cols_;
       auto coef = cur_row[idx] / base_elem;
-      std::transform(
-          base_row_begin, base_row_end, cur_row_begin, cur_row_begin,
-          [coef](const auto& a, const auto& b) { return b - coef * a; });
+      detail::simd::axpy(cur_row, base_row, cols_, -coef);
+      if (track) {
+        auto v = std::abs(cur_row[next]);
+        if (j == next || v > max) {
+          max = v;
+          pivot = j;
+        }
+      }
     }
+    return pivot;
   }
 
  public:  // computing functions
-  double det() const {
+  /**
+   * In-place LU factorization with partial pivoting: P * A = L * U.
+   * Strictly lower part of the matrix is replaced with L (unit diagonal
+   * implied), upper part - with U. At step i row i was swapped with
+   * row perm[i].
+   * @return false if matrix is singular.
+   */
+  bool luFactorize(vector::Vector<size_type>& perm,
+                   const LuOptions& opts = LuOptions()) {
+    static_assert(std::is_floating_point_v<value_type>,
+                  "LU factorization requires floating point matrix");
+    static_assert(kRowMajor, "in-place LU requires RowMajor layout");
+    if (!isSquare()) {
+      throw std::runtime_error("Matrix::luFactorize(): rows_ != cols_");
+    }
+
+    perm.resize(rows_);
+    return detail::luFactorize(data(), rows_, cols_, perm.data(), opts);
+  }
+
+  /**
+   * Factorization object reusable for det, solve, inverse and rank,
+   * see lu.hh. Rvalue overload factors in place without copying.
+   */
+  Lu<detail::FactorType<T>> lu(const LuOptions& opts = LuOptions()) const&;
+  Lu<detail::FactorType<T>> lu(const LuOptions& opts = LuOptions()) &&;
+
+  /**
+   * ColMajor storage is row-major storage of transpose, which has the
+   * same determinant, so both are computed in place. TileMajor is
+   * converted to RowMajor first.
+   */
+  double det(const LuOptions& opts = LuOptions()) const {
     if (!isSquare()) {
       throw std::runtime_error("Matrix::det(): rows_ != cols_");
     }
@@ -174,49 +515,84 @@ class Matrix final {
       throw std::runtime_error("Matrix::det(): matrix size must be > 0");
     }
 
-    auto calc_matrix = Matrix<double>(*this);
-    auto sign = 1.0;
-    for (size_type i = 0; i < cols_; ++i) {
-      auto pivot = i;
-      for (auto j = i + 1; j < rows_; ++j) {
-        if (std::abs(calc_matrix[j][i]) > std::abs(calc_matrix[pivot][i])) {
-          pivot = j;
-        }
-      }
-
-      if (calc_matrix.swapRows(i, pivot)) {
-        sign = -sign;
-      }
-
-      if (comparator::isClose<double>(calc_matrix[i][i], 0)) {
-        return 0;
-      }
-      calc_matrix.simplifyRows(i);
-    }
-
-    auto det = sign;
-    for (size_type i = 0; i < rows_; ++i) {
-      auto&& elem = calc_matrix[i][i];
-      assert(std::isfinite(elem));
-      det *= elem;
+    if constexpr (Layout::kStrided) {
+      return detail::denseDet(data(), rows_, rows_, opts);
+    } else {
+      return Matrix<T>(*this).det(opts);
     }
-    return det;
   }
 
+  /**
+   * Exact determinant of integer matrix by multi-modular elimination,
+   * see exact_det.hh. Residues are computed in parallel if pool is given.
+   */
+  BigInt exactDet(ThreadPool* pool = nullptr) const;
+
  public:  // static functions
   /** Creates eye matrix */
   static Matrix eye(size_type n) {
     Matrix m(n, n);
     for (auto i = size_type{0}; i < n; ++i) {
-      m[i][i] = static_cast<value_type>(1);
+      m(i, i) = static_cast<value_type>(1);
     }
     return m;
   }
 
+ private:
+  /** Storage of TileMajor is padded to whole tiles, keeps it zero */
+  void zeroPadding() {
+    if (data_.size() != rows_ * cols_) {
+      std::fill(data_.begin(), data_.end(), value_type());
+    }
+  }
+
  private:
   size_type rows_;
   size_type cols_;
   ContigiousContainer data_;
 };
 
+/**
+ * Matrix product of RowMajor or ColMajor operands, GEMM packing reads
+ * either of them through strides. Large products run on
+ * ThreadPool::global().
+ */
+template <typename T, typename LL, typename LR>
+Matrix<T> operator*(const Matrix<T, LL>& lhs, const Matrix<T, LR>& rhs) {
+  static_assert(LL::kStrided && LR::kStrided,
+                "operands must have strided layout");
+  if (lhs.cols() != rhs.rows()) {
+    throw std::runtime_error("operator*(): lhs.cols() != rhs.rows()");
+  }
+
+  auto m = lhs.rows();
+  auto k = lhs.cols();
+  auto n = rhs.cols();
+  Matrix<T> res(m, n);
+  detail::gemm(m, n, k, static_cast<T>(1), lhs.data(), LL::rowStride(m, k),
+               LL::colStride(m, k), rhs.data(), LR::rowStride(k, n),
+               LR::colStride(k, n), res.data(), n, &ThreadPool::global());
+  return res;
+}
+
+/**
+ * Matrix by column vector product.
+ */
+template <typename T>
+vector::Vector<T> operator*(const Matrix<T>& lhs,
+                            const vector::Vector<T>& rhs) {
+  if (lhs.cols() != rhs.size()) {
+    throw std::runtime_error("operator*(): lhs.cols() != rhs.size()");
+  }
+
+  vector::Vector<T> res(lhs.rows());
+  detail::gemv(lhs.rows(), lhs.cols(), static_cast<T>(1), lhs.data(),
+               lhs.cols(), rhs.data(), res.data(), &ThreadPool::global());
+  return res;
+}
+
 }  // namespace matrix
+
+// Lu and exactDet need complete Matrix, so they are defined after it
+#include "exact_det.hh"
+#include "lu.hh"
@@ -0,0 +1,262 @@
+/**
+ * Non-owning read-only views of strided matrix data.
+ */
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+
+#include "detail/gemm.hh"
+#include "exact_det.hh"
+#include "lu.hh"
+#include "matrix.hh"
+#include "thread_pool.hh"
+#include "vector/vector.hh"
+
+namespace matrix {
+
+/**
+ * Refers to size elements, element i at data + i * stride. Rows and
+ * columns of MatrixView are viewed with it.
+ */
+template <typename T>
+class VectorView final {
+ public:  // member types
+  using value_type = T;
+  using size_type = std::size_t;
+  using const_pointer = const value_type*;
+  using const_reference = const value_type&;
+
+ public:  // constructors
+  VectorView(const_pointer data, size_type size,
+             size_type stride = 1) noexcept
+      : data_(data), size_(size), stride_(stride) {}
+
+  VectorView(const vector::Vector<T>& v) noexcept
+      : VectorView(v.data(), v.size()) {}
+
+ public:  // accessors
+  const_reference operator[](size_type pos) const noexcept {
+    return data_[pos * stride_];
+  }
+
+  size_type size() const noexcept { return size_; }
+  size_type stride() const noexcept { return stride_; }
+  const_pointer data() const noexcept { return data_; }
+  bool isContiguous() const noexcept { return stride_ == 1; }
+
+  /** Copies viewed elements into owning vector */
+  vector::Vector<T> toVector() const {
+    vector::Vector<T> v(size_, vector::kDefaultInit);
+    for (size_type i = 0; i < size_; ++i) {
+      v[i] = operator[](i);
+    }
+    return v;
+  }
+
+ private:
+  const_pointer data_;
+  size_type size_;
+  size_type stride_;
+};
+
+/**
+ * Refers to rows x cols elements, element (i, j) at
+ * data + i * rowStride() + j * colStride(). Submatrices, transposes,
+ * rows and columns are views of the same memory, so blocks of a matrix
+ * or matrices embedded into larger buffers, e.g. mapped files, are
+ * computed over without copying. Data must outlive the view.
+ */
+template <typename T>
+class MatrixView final {
+  static_assert(std::is_arithmetic_v<T>);
+
+ public:  // member types
+  using value_type = T;
+  using size_type = std::size_t;
+  using const_pointer = const value_type*;
+  using const_reference = const value_type&;
+
+ public:  // constructors
+  MatrixView(const_pointer data, size_type rows, size_type cols,
+             size_type row_stride, size_type col_stride) noexcept
+      : data_(data),
+        rows_(rows),
+        cols_(cols),
+        row_stride_(row_stride),
+        col_stride_(col_stride) {}
+
+  /** Row-major data with leading dimension ld */
+  MatrixView(const_pointer data, size_type rows, size_type cols,
+             size_type ld) noexcept
+      : MatrixView(data, rows, cols, ld, 1) {}
+
+  MatrixView(const_pointer data, size_type rows, size_type cols) noexcept
+      : MatrixView(data, rows, cols, cols) {}
+
+  template <typename Layout>
+  MatrixView(const Matrix<T, Layout>& m) noexcept
+      : MatrixView(m.data(), m.rows(), m.cols(),
+                   Layout::rowStride(m.rows(), m.cols()),
+                   Layout::colStride(m.rows(), m.cols())) {
+    static_assert(Layout::kStrided, "matrix must have strided layout");
+  }
+
+ public:  // accessors
+  const_reference operator()(size_type row, size_type col) const noexcept {
+    return data_[row * row_stride_ + col * col_stride_];
+  }
+
+  VectorView<T> operator[](size_type pos) const noexcept { return row(pos); }
+
+  size_type rows() const noexcept { return rows_; }
+  size_type cols() const noexcept { return cols_; }
+  size_type rowStride() const noexcept { return row_stride_; }
+  size_type colStride() const noexcept { return col_stride_; }
+  const_pointer data() const noexcept { return data_; }
+
+  bool isSquare() const noexcept { return rows_ == cols_; }
+
+  /** Rows are contiguous, row-major kernels apply directly */
+  bool isRowMajor() const noexcept { return col_stride_ == 1; }
+  bool isColMajor() const noexcept { return row_stride_ == 1; }
+
+ public:  // views
+  VectorView<T> row(size_type pos) const noexcept {
+    return VectorView<T>(data_ + pos * row_stride_, cols_, col_stride_);
+  }
+
+  VectorView<T> col(size_type pos) const noexcept {
+    return VectorView<T>(data_ + pos * col_stride_, rows_, row_stride_);
+  }
+
+  /** Block of rows x cols elements starting at (row, col), O(1) */
+  MatrixView submatrix(size_type row, size_type col, size_type rows,
+                       size_type cols) const {
+    if (row + rows > rows_ || col + cols > cols_) {
+      throw std::runtime_error("MatrixView::submatrix(): out of range");
+    }
+    return MatrixView(data_ + row * row_stride_ + col * col_stride_, rows,
+                      cols, row_stride_, col_stride_);
+  }
+
+  /** O(1): strides are swapped */
+  MatrixView transposed() const noexcept {
+    return MatrixView(data_, cols_, rows_, col_stride_, row_stride_);
+  }
+
+ public:  // computing functions
+  /**
+   * Row-major views are computed in place, column-major ones as their
+   * transposes, which have the same determinant. Other strides are
+   * copied first.
+   */
+  double det(const LuOptions& opts = LuOptions()) const {
+    checkSquare("MatrixView::det()");
+    if (isRowMajor()) {
+      return detail::denseDet(data_, rows_, row_stride_, opts);
+    }
+    if (isColMajor()) {
+      return detail::denseDet(data_, rows_, col_stride_, opts);
+    }
+    return toMatrix().det(opts);
+  }
+
+  BigInt exactDet(ThreadPool* pool = nullptr) const {
+    checkSquare("MatrixView::exactDet()");
+    if (isRowMajor()) {
+      return detail::exactDet(data_, rows_, row_stride_, pool);
+    }
+    if (isColMajor()) {
+      return detail::exactDet(data_, rows_, col_stride_, pool);
+    }
+    return toMatrix().exactDet(pool);
+  }
+
+  Lu<detail::FactorType<T>> lu(const LuOptions& opts = LuOptions()) const {
+    return Lu<detail::FactorType<T>>(toMatrix<detail::FactorType<T>>(),
+                                     opts);
+  }
+
+  /** Copies viewed elements into owning matrix */
+  template <typename U = T>
+  Matrix<U> toMatrix() const {
+    Matrix<U> m(rows_, cols_, vector::kDefaultInit);
+    auto* dst = m.data();
+    for (size_type i = 0; i < rows_; ++i) {
+      for (size_type j = 0; j < cols_; ++j) {
+        *dst++ = static_cast<U>(operator()(i, j));
+      }
+    }
+    return m;
+  }
+
+ private:
+  void checkSquare(const char* func) const {
+    if (!isSquare()) {
+      throw std::runtime_error(std::string(func) + ": rows_ != cols_");
+    }
+
+    if (!rows_) {
+      throw std::runtime_error(std::string(func) +
+                               ": matrix size must be > 0");
+    }
+  }
+
+ private:
+  const_pointer data_;
+  size_type rows_;
+  size_type cols_;
+  size_type row_stride_;
+  size_type col_stride_;
+};
+
+/**
+ * Product of views with arbitrary strides, operands are not copied
+ * beyond GEMM packing. Large products run on ThreadPool::global().
+ */
+template <typename T>
+Matrix<T> operator*(MatrixView<T> lhs, MatrixView<T> rhs) {
+  if (lhs.cols() != rhs.rows()) {
+    throw std::runtime_error("operator*(): lhs.cols() != rhs.rows()");
+  }
+
+  Matrix<T> res(lhs.rows(), rhs.cols());
+  detail::gemm(lhs.rows(), rhs.cols(), lhs.cols(), static_cast<T>(1),
+               lhs.data(), lhs.rowStride(), lhs.colStride(), rhs.data(),
+               rhs.rowStride(), rhs.colStride(), res.data(), res.cols(),
+               &ThreadPool::global());
+  return res;
+}
+
+/**
+ * Strided matrix by strided vector product.
+ */
+template <typename T>
+vector::Vector<T> operator*(MatrixView<T> lhs, VectorView<T> rhs) {
+  if (lhs.cols() != rhs.size()) {
+    throw std::runtime_error("operator*(): lhs.cols() != rhs.size()");
+  }
+
+  vector::Vector<T> res(lhs.rows());
+  if (lhs.isRowMajor() && rhs.isContiguous()) {
+    detail::gemv(lhs.rows(), lhs.cols(), static_cast<T>(1), lhs.data(),
+                 lhs.rowStride(), rhs.data(), res.data(),
+                 &ThreadPool::global());
+  } else {
+    detail::gemm(lhs.rows(), 1, lhs.cols(), static_cast<T>(1), lhs.data(),
+                 lhs.rowStride(), lhs.colStride(), rhs.data(), rhs.stride(),
+                 1, res.data(), 1, &ThreadPool::global());
+  }
+  return res;
+}
+
+template <typename T>
+vector::Vector<T> operator*(MatrixView<T> lhs, const vector::Vector<T>& rhs) {
+  return lhs * VectorView<T>(rhs);
+}
+
+}  // namespace matrix
@@ -0,0 +1,325 @@
+/**
+ * LU factorization of sparse matrices.
+ */
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include <stdexcept>
+#include <type_traits>
+
+#include "comparator.hh"
+#include "detail/min_degree.hh"
+#include "sparse_matrix.hh"
+#include "vector/vector.hh"
+
+namespace matrix {
+
+/**
+ * Left-looking LU with threshold partial pivoting (Gilbert-Peierls):
+ * P * A * Q = L * U, where Q is fill-reducing column ordering and P is
+ * chosen during factorization. Column k of the factors is a sparse
+ * triangular solve with already computed columns of L, so the work is
+ * proportional to the number of floating point operations rather than
+ * to n^3, and memory is O(nnz(L) + nnz(U)).
+ *
+ * L and U are kept in compressed sparse column form. L has unit diagonal
+ * stored first in each column, U has diagonal stored last.
+ */
+template <typename T>
+class SparseLu final {
+  static_assert(std::is_floating_point_v<T>,
+                "LU factorization requires floating point matrix");
+
+ public:  // member types
+  using value_type = T;
+  using size_type = std::size_t;
+
+ public:  // constructors
+  template <typename U>
+  explicit SparseLu(const SparseMatrix<U>& a,
+                    const SparseLuOptions& opts = SparseLuOptions())
+      : n_(a.rows()) {
+    if (!a.isSquare()) {
+      throw std::runtime_error("SparseLu::SparseLu(): rows != cols");
+    }
+
+    if (!n_) {
+      throw std::runtime_error(
+          "SparseLu::SparseLu(): matrix size must be > 0");
+    }
+
+    if (opts.ordering == SparseOrdering::kMinDegree) {
+      q_ = detail::minDegreeOrder(n_, n_, a.rowPtr().data(),
+                                  a.colIdx().data());
+    } else {
+      q_.resize(n_, vector::kDefaultInit);
+      for (size_type k = 0; k < n_; ++k) {
+        q_[k] = k;
+      }
+    }
+
+    // rows of transposed CSR matrix are columns of a
+    nonsingular_ = factorize(a.transposed(), opts.pivot_tol);
+    det_ = 0;
+    if (nonsingular_) {
+      det_ = permutationSign(pinv_) * permutationSign(q_);
+      for (size_type k = 0; k < n_; ++k) {
+        det_ *= ux_[up_[k + 1] - 1];
+      }
+    }
+  }
+
+ public:  // accessors
+  size_type size() const noexcept { return n_; }
+  bool isSingular() const noexcept { return !nonsingular_; }
+
+  /** Nonzeros of factors, including unit diagonal of L */
+  size_type nnzL() const noexcept { return lx_.size(); }
+  size_type nnzU() const noexcept { return ux_.size(); }
+
+  /** k-th pivot column is colPerm()[k] of the original matrix */
+  const vector::Vector<size_type>& colPerm() const noexcept { return q_; }
+
+  /** Row i of the original matrix is rowPerm()[i]-th pivot row */
+  const vector::Vector<size_type>& rowPerm() const noexcept { return pinv_; }
+
+ public:  // computing functions
+  /** O(1): computed together with factorization */
+  double det() const noexcept { return det_; }
+
+  /** Solves A * x = b in O(n + nnz(L) + nnz(U)) */
+  vector::Vector<T> solve(const vector::Vector<T>& b) const {
+    if (b.size() != n_) {
+      throw std::runtime_error("SparseLu::solve(): b.size() != size()");
+    }
+
+    if (!nonsingular_) {
+      throw std::runtime_error("SparseLu::solve(): matrix is singular");
+    }
+
+    vector::Vector<T> y(n_, vector::kDefaultInit);
+    for (size_type i = 0; i < n_; ++i) {
+      y[pinv_[i]] = b[i];
+    }
+
+    for (size_type k = 0; k < n_; ++k) {
+      auto yk = y[k];
+      for (auto p = lp_[k] + 1; p < lp_[k + 1]; ++p) {
+        y[li_[p]] -= lx_[p] * yk;
+      }
+    }
+
+    for (size_type k = n_; k-- > 0;) {
+      auto last = up_[k + 1] - 1;
+      y[k] /= ux_[last];
+      auto yk = y[k];
+      for (auto p = up_[k]; p < last; ++p) {
+        y[ui_[p]] -= ux_[p] * yk;
+      }
+    }
+
+    vector::Vector<T> x(n_, vector::kDefaultInit);
+    for (size_type k = 0; k < n_; ++k) {
+      x[q_[k]] = y[k];
+    }
+    return x;
+  }
+
+ private:
+  static constexpr size_type kNone = std::numeric_limits<size_type>::max();
+
+  /** @param at CSR of transposed matrix, that is CSC of the original. */
+  template <typename U>
+  bool factorize(const SparseMatrix<U>& at, double tol) {
+    const auto* ap = at.rowPtr().data();
+    const auto* ai = at.colIdx().data();
+    const auto* ax = at.values().data();
+
+    pinv_.resize(n_, kNone);
+    lp_.reserve(n_ + 1);
+    up_.reserve(n_ + 1);
+    li_.reserve(at.nnz() + n_);
+    lx_.reserve(at.nnz() + n_);
+    ui_.reserve(at.nnz() + n_);
+    ux_.reserve(at.nnz() + n_);
+
+    vector::Vector<T> x(n_);
+    vector::Vector<size_type> xi(n_, vector::kDefaultInit);
+    vector::Vector<size_type> stack(n_, vector::kDefaultInit);
+    vector::Vector<size_type> pos(n_, vector::kDefaultInit);
+    vector::Vector<size_type> mark(n_, 0);
+
+    for (size_type k = 0; k < n_; ++k) {
+      lp_.push_back(li_.size());
+      up_.push_back(ui_.size());
+
+      // x = L \ A(:, col), nonzero pattern in topological order is
+      // xi[top..n)
+      auto col = q_[k];
+      auto stamp = k + 1;
+      auto top = n_;
+      for (auto p = ap[col]; p < ap[col + 1]; ++p) {
+        if (mark[ai[p]] != stamp) {
+          top = reach(ai[p], top, stamp, xi, stack, pos, mark);
+        }
+      }
+      for (auto p = ap[col]; p < ap[col + 1]; ++p) {
+        x[ai[p]] = static_cast<T>(ax[p]);
+      }
+      for (auto t = top; t < n_; ++t) {
+        auto j = xi[t];
+        auto jj = pinv_[j];
+        if (jj == kNone) {
+          continue;
+        }
+        auto xj = x[j];
+        for (auto p = lp_[jj] + 1; p < lp_[jj + 1]; ++p) {
+          x[li_[p]] -= lx_[p] * xj;
+        }
+      }
+
+      // rows already pivotal go to U, others are pivot candidates
+      auto ipiv = kNone;
+      auto largest = T{-1};
+      for (auto t = top; t < n_; ++t) {
+        auto i = xi[t];
+        if (pinv_[i] == kNone) {
+          if (std::abs(x[i]) > largest) {
+            largest = std::abs(x[i]);
+            ipiv = i;
+          }
+        } else {
+          ui_.push_back(pinv_[i]);
+          ux_.push_back(x[i]);
+        }
+      }
+
+      if (ipiv == kNone || comparator::isClose(largest, T{0})) {
+        for (auto t = top; t < n_; ++t) {
+          x[xi[t]] = 0;
+        }
+        return false;
+      }
+
+      // diagonal keeps the ordering if it is large enough
+      if (pinv_[col] == kNone && std::abs(x[col]) >= largest * tol) {
+        ipiv = col;
+      }
+
+      auto pivot = x[ipiv];
+      ui_.push_back(k);
+      ux_.push_back(pivot);
+      pinv_[ipiv] = k;
+
+      li_.push_back(ipiv);
+      lx_.push_back(1);
+      for (auto t = top; t < n_; ++t) {
+        auto i = xi[t];
+        if (pinv_[i] == kNone) {
+          li_.push_back(i);
+          lx_.push_back(x[i] / pivot);
+        }
+        x[i] = 0;
+      }
+    }
+    lp_.push_back(li_.size());
+    up_.push_back(ui_.size());
+
+    // L was built with original row indices, renumber them to pivot order
+    for (auto& i : li_) {
+      i = pinv_[i];
+    }
+    return true;
+  }
+
+  /**
+   * Nonblocking depth-first search from row j in the graph of L:
+   * pushes rows reachable from j to xi ending at top in topological order.
+   * @return new top.
+   */
+  size_type reach(size_type j, size_type top, size_type stamp,
+                  vector::Vector<size_type>& xi,
+                  vector::Vector<size_type>& stack,
+                  vector::Vector<size_type>& pos,
+                  vector::Vector<size_type>& mark) const {
+    size_type depth = 1;
+    stack[0] = j;
+    while (depth) {
+      j = stack[depth - 1];
+      auto jj = pinv_[j];
+      if (mark[j] != stamp) {
+        mark[j] = stamp;
+        pos[depth - 1] = jj == kNone ? 0 : lp_[jj] + 1;
+      }
+
+      auto end = jj == kNone ? 0 : lp_[jj + 1];
+      auto p = pos[depth - 1];
+      while (p < end && mark[li_[p]] == stamp) {
+        ++p;
+      }
+
+      if (p < end) {
+        pos[depth - 1] = p + 1;
+        stack[depth++] = li_[p];
+      } else {
+        --depth;
+        xi[--top] = j;
+      }
+    }
+    return top;
+  }
+
+  /** (-1)^(number of transpositions) of permutation */
+  static double permutationSign(const vector::Vector<size_type>& perm) {
+    vector::Vector<bool> seen(perm.size(), false);
+    auto sign = 1.0;
+    for (size_type i = 0; i < perm.size(); ++i) {
+      if (seen[i]) {
+        continue;
+      }
+      // cycle of length len is len - 1 transpositions
+      for (auto j = perm[i]; j != i; j = perm[j]) {
+        seen[j] = true;
+        sign = -sign;
+      }
+      seen[i] = true;
+    }
+    return sign;
+  }
+
+ private:
+  size_type n_;
+  vector::Vector<size_type> q_;
+  vector::Vector<size_type> pinv_;
+  vector::Vector<size_type> lp_;
+  vector::Vector<size_type> li_;
+  vector::Vector<T> lx_;
+  vector::Vector<size_type> up_;
+  vector::Vector<size_type> ui_;
+  vector::Vector<T> ux_;
+  bool nonsingular_;
+  double det_;
+};
+
+template <typename T>
+SparseLu<detail::FactorType<T>> SparseMatrix<T>::lu(
+    const SparseLuOptions& opts) const {
+  return SparseLu<detail::FactorType<T>>(*this, opts);
+}
+
+template <typename T>
+double SparseMatrix<T>::det(const SparseLuOptions& opts) const {
+  if (!isSquare()) {
+    throw std::runtime_error("SparseMatrix::det(): rows != cols");
+  }
+
+  if (!rows_) {
+    throw std::runtime_error("SparseMatrix::det(): matrix size must be > 0");
+  }
+
+  return lu(opts).det();
+}
+
+}  // namespace matrix
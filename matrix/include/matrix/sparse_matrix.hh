@@ -0,0 +1,217 @@
+/**
+ * Compressed sparse row matrix.
+ */
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+#include "matrix.hh"
+#include "vector/vector.hh"
+
+namespace matrix {
+
+template <typename T>
+class SparseLu;
+
+/** Fill-reducing column ordering used by sparse LU */
+enum class SparseOrdering {
+  kNatural,    ///< columns are eliminated in their order
+  kMinDegree,  ///< minimum degree on the pattern of A^T * A
+};
+
+/** Parameters of sparse LU factorization */
+struct SparseLuOptions {
+  SparseOrdering ordering = SparseOrdering::kMinDegree;
+  /**
+   * Threshold partial pivoting: diagonal element is kept as pivot if its
+   * magnitude is at least pivot_tol times the largest one in the column.
+   * 1 gives ordinary partial pivoting, smaller values preserve ordering
+   * and sparsity better.
+   */
+  double pivot_tol = 0.1;
+};
+
+/** Element given by its position, input of SparseMatrix */
+template <typename T>
+struct Triplet {
+  std::size_t row;
+  std::size_t col;
+  T value;
+};
+
+/**
+ * Row i keeps its nonzeros in positions [rowPtr()[i], rowPtr()[i + 1])
+ * of colIdx() and values(), sorted by column. Memory is O(rows + nnz).
+ * Compressed sparse column form of A is CSR of its transpose, see
+ * transposed().
+ */
+template <typename T>
+class SparseMatrix final {
+  static_assert(std::is_arithmetic_v<T>);
+
+ public:  // member types
+  using value_type = T;
+  using size_type = std::size_t;
+
+ public:  // constructors
+  explicit SparseMatrix(size_type rows = 0, size_type cols = 0)
+      : rows_(rows), cols_(cols), row_ptr_(rows + 1, 0) {}
+
+  /** Duplicate positions are summed up, explicit zeros are dropped */
+  template <typename It>
+  SparseMatrix(size_type rows, size_type cols, It first, It last)
+      : SparseMatrix(rows, cols) {
+    // counting sort by rows, then sort and merge within each row
+    for (auto it = first; it != last; ++it) {
+      if (it->row >= rows || it->col >= cols) {
+        throw std::runtime_error("SparseMatrix: triplet out of range");
+      }
+      ++row_ptr_[it->row + 1];
+    }
+    for (size_type i = 0; i < rows; ++i) {
+      row_ptr_[i + 1] += row_ptr_[i];
+    }
+
+    auto nnz = row_ptr_[rows];
+    vector::Vector<std::pair<size_type, T>> entries(nnz);
+    auto next = row_ptr_;
+    for (auto it = first; it != last; ++it) {
+      entries[next[it->row]++] = {it->col, static_cast<T>(it->value)};
+    }
+
+    col_idx_.reserve(nnz);
+    values_.reserve(nnz);
+    size_type end = 0;
+    for (size_type i = 0; i < rows; ++i) {
+      auto* b = entries.data() + row_ptr_[i];
+      auto* e = entries.data() + row_ptr_[i + 1];
+      std::sort(b, e, [](const auto& lhs, const auto& rhs) {
+        return lhs.first < rhs.first;
+      });
+
+      row_ptr_[i] = end;
+      for (auto* p = b; p != e;) {
+        auto col = p->first;
+        auto sum = T{0};
+        for (; p != e && p->first == col; ++p) {
+          sum += p->second;
+        }
+        if (sum != T{0}) {
+          col_idx_.push_back(col);
+          values_.push_back(sum);
+          ++end;
+        }
+      }
+    }
+    row_ptr_[rows] = end;
+  }
+
+  /** Keeps nonzero elements of dense matrix */
+  explicit SparseMatrix(const Matrix<T>& dense)
+      : SparseMatrix(dense.rows(), dense.cols()) {
+    for (size_type i = 0; i < rows_; ++i) {
+      for (size_type j = 0; j < cols_; ++j) {
+        if (dense[i][j] != T{0}) {
+          col_idx_.push_back(j);
+          values_.push_back(dense[i][j]);
+        }
+      }
+      row_ptr_[i + 1] = col_idx_.size();
+    }
+  }
+
+  Matrix<T> toDense() const {
+    Matrix<T> dense(rows_, cols_);
+    for (size_type i = 0; i < rows_; ++i) {
+      for (auto p = row_ptr_[i]; p < row_ptr_[i + 1]; ++p) {
+        dense[i][col_idx_[p]] = values_[p];
+      }
+    }
+    return dense;
+  }
+
+ public:  // accessors
+  size_type rows() const noexcept { return rows_; }
+  size_type cols() const noexcept { return cols_; }
+  size_type nnz() const noexcept { return values_.size(); }
+  bool isSquare() const noexcept { return rows_ == cols_; }
+
+  const vector::Vector<size_type>& rowPtr() const noexcept { return row_ptr_; }
+  const vector::Vector<size_type>& colIdx() const noexcept { return col_idx_; }
+  const vector::Vector<T>& values() const noexcept { return values_; }
+
+  /** O(log(nnz in row)) lookup, zero if element is not stored */
+  T at(size_type row, size_type col) const noexcept {
+    auto* b = col_idx_.data() + row_ptr_[row];
+    auto* e = col_idx_.data() + row_ptr_[row + 1];
+    auto* p = std::lower_bound(b, e, col);
+    return p != e && *p == col ? values_[p - col_idx_.data()] : T{0};
+  }
+
+ public:  // computing functions
+  /** O(rows + cols + nnz) */
+  SparseMatrix transposed() const {
+    SparseMatrix t(cols_, rows_);
+    t.col_idx_.resize(nnz(), vector::kDefaultInit);
+    t.values_.resize(nnz(), vector::kDefaultInit);
+    for (size_type p = 0; p < nnz(); ++p) {
+      ++t.row_ptr_[col_idx_[p] + 1];
+    }
+    for (size_type j = 0; j < cols_; ++j) {
+      t.row_ptr_[j + 1] += t.row_ptr_[j];
+    }
+
+    auto next = t.row_ptr_;
+    for (size_type i = 0; i < rows_; ++i) {
+      for (auto p = row_ptr_[i]; p < row_ptr_[i + 1]; ++p) {
+        auto q = next[col_idx_[p]]++;
+        t.col_idx_[q] = i;
+        t.values_[q] = values_[p];
+      }
+    }
+    return t;
+  }
+
+  /** Sparse LU factorization, see sparse_lu.hh */
+  SparseLu<detail::FactorType<T>> lu(
+      const SparseLuOptions& opts = SparseLuOptions()) const;
+
+  /** Time and memory depend on fill-in, close to O(nnz) for good orderings */
+  double det(const SparseLuOptions& opts = SparseLuOptions()) const;
+
+ private:
+  size_type rows_;
+  size_type cols_;
+  vector::Vector<size_type> row_ptr_;
+  vector::Vector<size_type> col_idx_;
+  vector::Vector<T> values_;
+};
+
+/** Sparse matrix by dense vector product */
+template <typename T>
+vector::Vector<T> operator*(const SparseMatrix<T>& lhs,
+                            const vector::Vector<T>& rhs) {
+  if (lhs.cols() != rhs.size()) {
+    throw std::runtime_error("operator*(): lhs.cols() != rhs.size()");
+  }
+
+  vector::Vector<T> res(lhs.rows());
+  const auto& ptr = lhs.rowPtr();
+  for (std::size_t i = 0; i < lhs.rows(); ++i) {
+    auto sum = T{0};
+    for (auto p = ptr[i]; p < ptr[i + 1]; ++p) {
+      sum += lhs.values()[p] * rhs[lhs.colIdx()[p]];
+    }
+    res[i] = sum;
+  }
+  return res;
+}
+
+}  // namespace matrix
+
+// SparseLu needs complete SparseMatrix, so it is defined after it
+#include "sparse_lu.hh"
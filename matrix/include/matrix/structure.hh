@@ -0,0 +1,101 @@
+/**
+ * Detection of zero structure of square matrices.
+ */
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+
+#include "vector/vector.hh"
+
+namespace matrix {
+
+/**
+ * Zero structure of n x n matrix. Only exact zeros are structural,
+ * so that detection never changes the result of computations.
+ */
+struct Structure {
+  /** Band LU is chosen if band is at most 1 / kBandRatio of matrix size */
+  static constexpr std::size_t kBandRatio = 4;
+
+  std::size_t size = 0;
+  std::size_t lower_bandwidth = 0;  ///< max i - j over nonzero a[i][j]
+  std::size_t upper_bandwidth = 0;  ///< max j - i over nonzero a[i][j]
+  bool has_zero_row = false;
+
+  /** Block b spans rows and columns [blocks[b], blocks[b + 1]) */
+  vector::Vector<std::size_t> blocks;
+
+  bool isDiagonal() const noexcept {
+    return !lower_bandwidth && !upper_bandwidth;
+  }
+  bool isLowerTriangular() const noexcept { return !upper_bandwidth; }
+  bool isUpperTriangular() const noexcept { return !lower_bandwidth; }
+  bool isTriangular() const noexcept {
+    return isLowerTriangular() || isUpperTriangular();
+  }
+
+  /** Row interchanges widen U to kl + ku superdiagonals */
+  std::size_t bandStorageWidth() const noexcept {
+    return 2 * lower_bandwidth + upper_bandwidth + 1;
+  }
+  bool isBanded() const noexcept {
+    return bandStorageWidth() * kBandRatio <= size;
+  }
+
+  std::size_t numBlocks() const noexcept { return blocks.size() - 1; }
+  bool isBlockDiagonal() const noexcept { return numBlocks() > 1; }
+};
+
+/**
+ * Finds bandwidths and the finest splitting into diagonal blocks of
+ * n x n row-major matrix with leading dimension lda. Each row is scanned
+ * from both ends up to its first and last nonzero, so analysis is O(n)
+ * for dense matrices and O(n^2) at worst.
+ */
+template <typename T>
+Structure analyzeStructure(const T* a, std::size_t n, std::size_t lda) {
+  Structure s;
+  s.size = n;
+
+  // row i touches columns [first[i], last[i]] besides the diagonal
+  vector::Vector<std::size_t> first(n, vector::kDefaultInit);
+  vector::Vector<std::size_t> last(n, vector::kDefaultInit);
+  for (std::size_t i = 0; i < n; ++i) {
+    const auto* row = a + i * lda;
+    auto f = std::find_if(row, row + n, [](T x) { return x != T{0}; });
+    if (f == row + n) {
+      s.has_zero_row = true;
+      s.blocks.push_back(0);
+      s.blocks.push_back(n);
+      return s;
+    }
+
+    std::size_t l = n - 1;
+    while (row[l] == T{0}) {
+      --l;
+    }
+    first[i] = std::min<std::size_t>(f - row, i);
+    last[i] = std::max(l, i);
+    s.lower_bandwidth = std::max(s.lower_bandwidth, i - first[i]);
+    s.upper_bandwidth = std::max(s.upper_bandwidth, last[i] - i);
+  }
+
+  // block ends before k if no row above reaches k and no row below
+  // reaches back before k
+  for (auto k = n; k-- > 1;) {
+    first[k - 1] = std::min(first[k - 1], first[k]);
+  }
+  s.blocks.push_back(0);
+  std::size_t reach = 0;
+  for (std::size_t k = 1; k < n; ++k) {
+    reach = std::max(reach, last[k - 1]);
+    if (reach < k && first[k] >= k) {
+      s.blocks.push_back(k);
+    }
+  }
+  s.blocks.push_back(n);
+  return s;
+}
+
+}  // namespace matrix
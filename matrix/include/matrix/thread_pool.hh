@@ -0,0 +1,184 @@
+/**
+ * Persistent pool of worker threads used by parallel computations.
+ */
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <utility>
+
+#include "vector/vector.hh"
+
+namespace matrix {
+
+class ThreadPool final {
+ public:  // constructors and destructor
+  /** Spawns num_threads workers (at least one) */
+  explicit ThreadPool(
+      std::size_t num_threads = std::thread::hardware_concurrency()) {
+    num_threads = std::max(num_threads, std::size_t{1});
+    workers_.reserve(num_threads);
+    for (std::size_t i = 0; i < num_threads; ++i) {
+      workers_.emplace_back([this] { workerLoop(); });
+    }
+  }
+
+  ThreadPool(const ThreadPool&) = delete;
+  ThreadPool& operator=(const ThreadPool&) = delete;
+
+  ~ThreadPool() {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      stop_ = true;
+    }
+    cv_.notify_all();
+    for (auto it = workers_.begin(), end = workers_.end(); it != end; ++it) {
+      it->join();
+    }
+  }
+
+ public:
+  /** Process-wide pool used when caller does not provide one */
+  static ThreadPool& global() {
+    static ThreadPool pool;
+    return pool;
+  }
+
+  std::size_t size() const noexcept { return workers_.size(); }
+
+  /** Enqueues a task, result is available through returned future */
+  template <typename F>
+  auto submit(F&& f) -> std::future<std::invoke_result_t<std::decay_t<F>>> {
+    using Result = std::invoke_result_t<std::decay_t<F>>;
+    // std::function requires copyable callable
+    auto task =
+        std::make_shared<std::packaged_task<Result()>>(std::forward<F>(f));
+    auto fut = task->get_future();
+    enqueue([task] { (*task)(); });
+    return fut;
+  }
+
+  /**
+   * Splits [begin, end) into at most size() chunks not smaller than grain
+   * and calls f(chunk_begin, chunk_end) for each of them in parallel.
+   * Calling thread takes chunks too and never runs unrelated tasks while
+   * waiting, so it is safe to call parallelFor from inside of a task.
+   */
+  template <typename F>
+  void parallelFor(std::size_t begin, std::size_t end, std::size_t grain,
+                   F&& f) {
+    if (begin >= end) {
+      return;
+    }
+
+    auto len = end - begin;
+    auto num_chunks = std::min(size(), len / std::max(grain, std::size_t{1}));
+    if (num_chunks <= 1) {
+      f(begin, end);
+      return;
+    }
+
+    // helpers may be dequeued after return, so state is shared with them
+    auto state = std::make_shared<ForState>();
+    state->num_chunks = num_chunks;
+    state->remaining = num_chunks;
+    auto chunk = len / num_chunks;
+    auto extra = len % num_chunks;
+    state->run = [&f, begin, chunk, extra](std::size_t idx) {
+      auto b = begin + idx * chunk + std::min(idx, extra);
+      auto e = b + chunk + (idx < extra ? 1 : 0);
+      f(b, e);
+    };
+
+    for (std::size_t c = 1; c < num_chunks; ++c) {
+      enqueue([state] { runChunks(*state); });
+    }
+    runChunks(*state);
+
+    // chunks left were taken by workers which are running them now
+    std::unique_lock<std::mutex> lock(state->mutex);
+    state->done.wait(lock, [&state] { return state->remaining == 0; });
+    if (state->error) {
+      std::rethrow_exception(state->error);
+    }
+  }
+
+ private:
+  struct ForState {
+    std::function<void(std::size_t)> run;
+    std::size_t num_chunks = 0;
+    std::atomic<std::size_t> next = 0;
+    std::size_t remaining = 0;  ///< guarded by mutex
+    std::mutex mutex;
+    std::condition_variable done;
+    std::exception_ptr error;
+  };
+
+  /** Takes chunks of parallelFor until none is left */
+  static void runChunks(ForState& state) {
+    for (;;) {
+      auto idx = state.next++;
+      if (idx >= state.num_chunks) {
+        return;
+      }
+
+      std::exception_ptr error;
+      try {
+        state.run(idx);
+      } catch (...) {
+        error = std::current_exception();
+      }
+
+      std::lock_guard<std::mutex> lock(state.mutex);
+      if (error && !state.error) {
+        state.error = error;
+      }
+      if (--state.remaining == 0) {
+        state.done.notify_all();
+      }
+    }
+  }
+
+  void enqueue(std::function<void()> task) {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      tasks_.push_back(std::move(task));
+    }
+    cv_.notify_one();
+  }
+
+  void workerLoop() {
+    for (;;) {
+      std::function<void()> task;
+      {
+        std::unique_lock<std::mutex> lock(mutex_);
+        cv_.wait(lock, [this] { return stop_ || !tasks_.empty(); });
+        if (stop_ && tasks_.empty()) {
+          return;
+        }
+        task = std::move(tasks_.front());
+        tasks_.pop_front();
+      }
+      task();
+    }
+  }
+
+ private:
+  vector::Vector<std::thread> workers_;
+  std::deque<std::function<void()>> tasks_;
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  bool stop_ = false;
+};
+
+}  // namespace matrix
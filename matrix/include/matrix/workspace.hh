@@ -0,0 +1,63 @@
+/**
+ * Reusable scratch memory for determinant and LU computations.
+ */
+#pragma once
+
+#include <cstddef>
+
+#include "vector/aligned_allocator.hh"
+#include "vector/vector.hh"
+
+namespace matrix {
+
+/**
+ * Buffers grow on demand and are never shrunk until release(), so
+ * repeated computations on matrices of similar size do not allocate.
+ * Workspace is not thread-safe: one workspace must not be used by
+ * several computations at once.
+ */
+class Workspace final {
+ public:
+  /**
+   * Returns buffer for n x n working copy with padded row stride.
+   * Contents of the buffer are unspecified.
+   */
+  double* matrix(std::size_t n, std::size_t ld) {
+    grow(matrix_, n * ld);
+    return matrix_.data();
+  }
+
+  std::size_t* pivots(std::size_t n) {
+    grow(pivots_, n);
+    return pivots_.data();
+  }
+
+  /** Number of matrix elements available without reallocation */
+  std::size_t capacity() const noexcept { return matrix_.size(); }
+
+  /** Frees all memory held */
+  void release() noexcept {
+    matrix_ = decltype(matrix_)();
+    pivots_ = decltype(pivots_)();
+  }
+
+  /** Workspace used by computations that were not given one */
+  static Workspace& threadLocal() {
+    thread_local Workspace ws;
+    return ws;
+  }
+
+ private:
+  template <typename Buffer>
+  static void grow(Buffer& buf, std::size_t sz) {
+    if (buf.size() < sz) {
+      buf.resize(sz, vector::kDefaultInit);
+    }
+  }
+
+ private:
+  vector::Vector<double, vector::AlignedAllocator<double>> matrix_;
+  vector::Vector<std::size_t> pivots_;
+};
+
+}  // namespace matrix
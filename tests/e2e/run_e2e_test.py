@@ -2,6 +2,7 @@ import config
 import os
 import numpy as np
 import subprocess
+import tempfile
 
 def getDeterminantFromNumPy(matrix):
   """Computes the determinant using NumPy."""
@@ -30,6 +31,52 @@ def getAns(file):
   with open(file, 'r') as f:
     return float(f.readline().strip())
 
+def testBatch(input_dir, ans_dir, num_tests):
+  """Feeds all inputs as one stream to driver in batch mode."""
+  stream = ""
+  for i in range(num_tests):
+    with open(input_dir + f"test_{i + 1}.in", 'r') as f:
+      stream += f.read() + "\n"
+
+  file_path = os.path.abspath(os.path.dirname(__file__))
+  process = subprocess.run(
+    [file_path + "/../../build/driver/driver", "--batch"],
+    input=stream, text=True, capture_output=True
+  )
+  if process.returncode != 0:
+    raise RuntimeError(f"External program failed: {process.stderr}")
+
+  results = process.stdout.split()
+  if len(results) != num_tests:
+    raise RuntimeError(f"❌ Expected {num_tests} results, got {len(results)}")
+
+  for i in range(num_tests):
+    det_python = getAns(ans_dir + f"ans_{i + 1}.out")
+    if not np.isclose(det_python, float(results[i]), rtol=1e-3):
+      raise RuntimeError(f"❌ Batch determinant {i + 1} does not match")
+  print("✅ Batch determinants match!")
+
+def testOutOfCore(input_dir, ans_dir, num_tests):
+  """Runs driver over panel file on disk with small memory budget."""
+  file_path = os.path.abspath(os.path.dirname(__file__))
+  scratch = os.path.join(tempfile.gettempdir(), f"e2e_panels_{os.getpid()}")
+  for i in range(num_tests):
+    with open(input_dir + f"test_{i + 1}.in", 'r') as infile:
+      process = subprocess.run(
+        [file_path + "/../../build/driver/driver", "--out-of-core", scratch,
+         "--memory-budget", "1"],
+        stdin=infile, text=True, capture_output=True
+      )
+    if process.returncode != 0:
+      raise RuntimeError(f"External program failed: {process.stderr}")
+    if os.path.exists(scratch):
+      raise RuntimeError("❌ Scratch file was not removed")
+
+    det_python = getAns(ans_dir + f"ans_{i + 1}.out")
+    if not np.isclose(det_python, float(process.stdout), rtol=1e-3):
+      raise RuntimeError(f"❌ Out-of-core determinant {i + 1} does not match")
+  print("✅ Out-of-core determinants match!")
+
 def test(input_dir, ans_dir, num_tests):
   for i in range(num_tests):
     input_file = input_dir + f"test_{i + 1}.in"
@@ -51,3 +98,7 @@ test(input_dir=config.input_dir, ans_dir=config.ans_dir,
      num_tests=config.NUM_TESTS)
 test(input_dir=config.ext_input_dir, ans_dir=config.ext_ans_dir,
      num_tests=config.NUM_EXT_TESTS)
+testBatch(input_dir=config.input_dir, ans_dir=config.ans_dir,
+          num_tests=config.NUM_TESTS)
+testOutOfCore(input_dir=config.input_dir, ans_dir=config.ans_dir,
+              num_tests=config.NUM_TESTS)
@@ -0,0 +1,397 @@
+#include <unistd.h>
+
+#include <charconv>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <numeric>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+#include "gtest/gtest.h"
+#include "io/binary_format.hh"
+#include "io/input_buffer.hh"
+#include "io/matrix_io.hh"
+#include "io/out_of_core.hh"
+#include "io/text_parser.hh"
+
+TEST(text_parser, numbers) {
+  io::TextParser parser(" 3\n-1.5e2\t+2 0.25  \r\n");
+  ASSERT_EQ(parser.next<std::size_t>(), 3);
+  ASSERT_EQ(parser.next<double>(), -150.0);
+  ASSERT_EQ(parser.next<double>(), 2.0);
+  ASSERT_EQ(parser.next<double>(), 0.25);
+  ASSERT_TRUE(parser.atEnd());
+  ASSERT_THROW(parser.next<double>(), std::runtime_error);
+}
+
+TEST(text_parser, fast_path_exact) {
+  std::mt19937 gen(7);
+  std::uniform_real_distribution<double> dist(-1e3, 1e3);
+  for (int i = 0; i < 10000; ++i) {
+    char buf[64];
+    auto len = std::snprintf(buf, sizeof(buf), i % 2 ? "%.6f" : "%.15e",
+                             dist(gen));
+    double expected;
+    std::from_chars(buf, buf + len, expected);
+    io::TextParser parser(std::string_view(buf, len));
+    ASSERT_EQ(parser.next<double>(), expected) << buf;
+  }
+}
+
+TEST(text_parser, malformed) {
+  io::TextParser p1("1.0 2x");
+  p1.next<double>();
+  ASSERT_THROW(p1.next<double>(), std::runtime_error);
+
+  io::TextParser p2("abc");
+  ASSERT_THROW(p2.next<double>(), std::runtime_error);
+
+  io::TextParser p3("-3");
+  ASSERT_THROW(p3.next<std::size_t>(), std::runtime_error);
+}
+
+TEST(matrix_io, read_square) {
+  io::TextParser parser("2 1 2\n3 4\n");
+  auto m = io::readSquareMatrix<double>(parser);
+  ASSERT_EQ(m.rows(), 2);
+  ASSERT_EQ(m[1][0], 3.0);
+  ASSERT_EQ(m.det(), -2.0);
+
+  io::TextParser truncated("3 1 2 3");
+  ASSERT_THROW(io::readSquareMatrix<double>(truncated), std::runtime_error);
+}
+
+TEST(matrix_io, read_coordinate) {
+  io::TextParser parser("3 4\n0 1 2\n2 0 4\n1 2 3\n2 0 1\n");
+  auto s = io::readCoordinateMatrix<double>(parser);
+  ASSERT_EQ(s.nnz(), 3);
+  ASSERT_EQ(s.at(2, 0), 5.0);
+  ASSERT_EQ(s.det(), 30.0);
+
+  io::TextParser out_of_range("2 1\n2 0 1\n");
+  ASSERT_THROW(io::readCoordinateMatrix<double>(out_of_range),
+               std::runtime_error);
+}
+
+TEST(input_buffer, file_and_pipe) {
+  const std::string text = "2 1 0 0 1\n";
+  char path[] = "/tmp/io_unit_test_XXXXXX";
+  auto fd = ::mkstemp(path);
+  ASSERT_GE(fd, 0);
+  ASSERT_EQ(::write(fd, text.data(), text.size()),
+            static_cast<ssize_t>(text.size()));
+  ::close(fd);
+
+  auto mapped = io::InputBuffer::fromFile(path);
+  ASSERT_TRUE(mapped.isMapped());
+  ASSERT_EQ(mapped.view(), text);
+  ::unlink(path);
+
+  int fds[2];
+  ASSERT_EQ(::pipe(fds), 0);
+  ASSERT_EQ(::write(fds[1], text.data(), text.size()),
+            static_cast<ssize_t>(text.size()));
+  ::close(fds[1]);
+  auto piped = io::InputBuffer::fromFd(fds[0]);
+  ::close(fds[0]);
+  ASSERT_FALSE(piped.isMapped());
+  ASSERT_EQ(piped.view(), text);
+
+  ASSERT_THROW(io::InputBuffer::fromFile("/nonexistent/file"),
+               std::runtime_error);
+}
+
+TEST(input_buffer, large_pipe) {
+  // several read blocks, the last one partial
+  std::string text(5 * (1 << 20) + 12345, '\0');
+  for (std::size_t i = 0; i < text.size(); ++i) {
+    text[i] = static_cast<char>('a' + i % 26);
+  }
+
+  int fds[2];
+  ASSERT_EQ(::pipe(fds), 0);
+  std::thread writer([&] {
+    for (std::size_t pos = 0; pos < text.size();) {
+      auto got = ::write(fds[1], text.data() + pos, text.size() - pos);
+      if (got <= 0) {
+        break;
+      }
+      pos += static_cast<std::size_t>(got);
+    }
+    ::close(fds[1]);
+  });
+  auto piped = io::InputBuffer::fromFd(fds[0]);
+  writer.join();
+  ::close(fds[0]);
+  ASSERT_FALSE(piped.isMapped());
+  ASSERT_EQ(piped.size(), text.size());
+  ASSERT_TRUE(piped.view() == text);
+}
+
+TEST(text_parser, streaming) {
+  std::string text;
+  for (int i = 0; i < 2000; ++i) {
+    text += std::to_string(i) + (i % 7 ? " " : "\n");
+  }
+
+  int fds[2];
+  ASSERT_EQ(::pipe(fds), 0);
+  ASSERT_EQ(::write(fds[1], text.data(), text.size()),
+            static_cast<ssize_t>(text.size()));
+  ::close(fds[1]);
+
+  // small window makes tokens cross refill boundaries
+  io::TextParser parser(fds[0], 256);
+  for (int i = 0; i < 2000; ++i) {
+    ASSERT_EQ(parser.next<int>(), i);
+  }
+  ASSERT_TRUE(parser.atEnd());
+  ASSERT_EQ(parser.offset(), text.size());
+  ::close(fds[0]);
+}
+
+TEST(text_parser, long_token_at_window_end) {
+  // 200-character number starts 150 bytes before the end of the first
+  // window of 256 bytes
+  std::string text;
+  for (int i = 0; i < 53; ++i) {
+    text += "9 ";
+  }
+  text += "1." + std::string(198, '0') + " 7\n";
+
+  int fds[2];
+  ASSERT_EQ(::pipe(fds), 0);
+  ASSERT_EQ(::write(fds[1], text.data(), text.size()),
+            static_cast<ssize_t>(text.size()));
+  ::close(fds[1]);
+
+  io::TextParser parser(fds[0], 256);
+  for (int i = 0; i < 53; ++i) {
+    ASSERT_EQ(parser.next<double>(), 9.0);
+  }
+  ASSERT_EQ(parser.next<double>(), 1.0);
+  ASSERT_EQ(parser.next<double>(), 7.0);
+  ASSERT_TRUE(parser.atEnd());
+  ::close(fds[0]);
+}
+
+TEST(text_parser, parallel_read) {
+  // about 6 MiB of text, enough for several chunks
+  constexpr std::size_t n = 700;
+  std::mt19937 gen(5);
+  std::uniform_real_distribution<double> dist(-1e3, 1e3);
+  const char* const kSpaces[] = {" ", "\t", "\n", "  \r\n"};
+  std::string text = std::to_string(n) + "\n";
+  for (std::size_t i = 0; i < n * n; ++i) {
+    auto v = dist(gen);
+    text += (v > 0 && i % 11 == 0 ? "+" : "") + std::to_string(v);
+    text += kSpaces[i % 4];
+  }
+  auto record_end = text.size();
+  text += "2 1 2 3 4";
+
+  io::TextParser serial_parser(text);
+  auto expected = io::readSquareMatrix<double>(serial_parser);
+  matrix::ThreadPool pool(4);
+  io::TextParser parser(text);
+  auto m = io::readSquareMatrix<double>(parser, pool);
+  ASSERT_EQ(m.rows(), n);
+  ASSERT_TRUE(std::equal(m.cbegin(), m.cend(), expected.cbegin()));
+  // reading stops right after the last element
+  ASSERT_LE(parser.offset(), record_end);
+  ASSERT_EQ(io::readSquareMatrix<double>(parser, pool).det(), -2.0);
+  ASSERT_TRUE(parser.atEnd());
+
+  auto truncated = text.substr(0, record_end / 2);
+  io::TextParser short_parser(truncated);
+  ASSERT_THROW(io::readSquareMatrix<double>(short_parser, pool),
+               std::runtime_error);
+
+  // offset of malformed token is relative to the whole text
+  auto bad = text;
+  auto bad_pos = bad.find(' ', bad.size() * 3 / 4) + 1;
+  bad[bad_pos] = 'x';
+  io::TextParser bad_parser(bad);
+  try {
+    io::readSquareMatrix<double>(bad_parser, pool);
+    FAIL();
+  } catch (std::runtime_error& ex) {
+    ASSERT_NE(std::string(ex.what()).find(std::to_string(bad_pos)),
+              std::string::npos)
+        << ex.what();
+  }
+}
+
+namespace {
+
+std::string tempPath() {
+  char path[] = "/tmp/io_unit_test_XXXXXX";
+  auto fd = ::mkstemp(path);
+  ::close(fd);
+  return path;
+}
+
+}  // namespace
+
+TEST(binary_format, roundtrip) {
+  matrix::Matrix<double> m(3, 3);
+  std::iota(m.begin(), m.end(), 1.0);
+  m[2][2] = 10;
+
+  auto path = tempPath();
+  {
+    std::ofstream os(path, std::ios::binary);
+    io::writeBinary(os, m, 5);
+  }
+
+  auto mm = io::MappedMatrix::fromFile(path);
+  ::unlink(path.c_str());
+  ASSERT_EQ(mm.header().ld, 5);
+  ASSERT_EQ(mm.header().data_offset % io::kDefaultBinaryAlignment, 0);
+  auto view = mm.view<double>();
+  ASSERT_EQ(reinterpret_cast<std::uintptr_t>(view.data()) %
+                io::kDefaultBinaryAlignment,
+            0);
+  ASSERT_EQ(view[2][1], 8.0);
+  ASSERT_TRUE(comparator::isClose(view.det(), m.det()));
+  ASSERT_THROW(mm.view<float>(), std::runtime_error);
+}
+
+TEST(binary_format, col_major) {
+  std::ostringstream os;
+  // clang-format off
+  std::int32_t elems[] = {1, 2,
+                          3, 4,
+                          5, 6};
+  // clang-format on
+  io::writeBinary(os, matrix::MatrixView<std::int32_t>(elems, 3, 2));
+  auto bytes = os.str();
+  auto* hdr = reinterpret_cast<io::BinaryHeader*>(bytes.data());
+  hdr->layout = io::Layout::kColMajor;
+  std::swap(hdr->rows, hdr->cols);
+
+  auto path = tempPath();
+  std::ofstream(path, std::ios::binary) << bytes;
+  auto mm = io::MappedMatrix::fromFile(path);
+  ::unlink(path.c_str());
+  // elements are stored by columns of 2 x 3 matrix
+  auto view = mm.view<std::int32_t>();
+  ASSERT_EQ(view.rows(), 2);
+  ASSERT_EQ(view.cols(), 3);
+  ASSERT_TRUE(view.isColMajor());
+  for (std::size_t i = 0; i < 2; ++i) {
+    for (std::size_t j = 0; j < 3; ++j) {
+      ASSERT_EQ(view(i, j), elems[j * 2 + i]);
+    }
+  }
+  ASSERT_EQ(view.toMatrix()(0, 1), 3);
+}
+
+TEST(binary_format, corrupted) {
+  matrix::Matrix<float> m(4, 4, 1.0f);
+  std::ostringstream os;
+  io::writeBinary(os, m);
+  auto good = os.str();
+
+  auto check = [](const std::string& bytes) {
+    auto path = tempPath();
+    std::ofstream(path, std::ios::binary) << bytes;
+    EXPECT_THROW(io::MappedMatrix::fromFile(path), std::runtime_error);
+    ::unlink(path.c_str());
+  };
+
+  check(good.substr(0, good.size() - 1));
+  check(good.substr(0, 10));
+
+  auto bad_magic = good;
+  bad_magic[0] = 'X';
+  check(bad_magic);
+
+  auto huge = good;
+  reinterpret_cast<io::BinaryHeader*>(huge.data())->rows = ~0ull / 2;
+  check(huge);
+
+  // consistent with alignment of 1, but floats would be misaligned
+  auto misaligned = good;
+  misaligned.insert(io::kDefaultBinaryAlignment, 1, '\0');
+  auto* hdr = reinterpret_cast<io::BinaryHeader*>(misaligned.data());
+  hdr->alignment = 1;
+  hdr->data_offset = io::kDefaultBinaryAlignment + 1;
+  auto path = tempPath();
+  std::ofstream(path, std::ios::binary) << misaligned;
+  try {
+    io::MappedMatrix::fromFile(path);
+    ADD_FAILURE() << "misaligned data offset is accepted";
+  } catch (std::runtime_error& ex) {
+    EXPECT_NE(std::string(ex.what()).find("not aligned"), std::string::npos)
+        << ex.what();
+  }
+  ::unlink(path.c_str());
+}
+
+TEST(out_of_core, det) {
+  constexpr std::size_t kSize = 70;
+  std::mt19937 gen(11);
+  std::uniform_real_distribution<double> dist(-1, 1);
+  matrix::Matrix<double> m(kSize, kSize);
+  for (auto& elem : m) {
+    elem = dist(gen);
+  }
+  auto expected = m.det();
+
+  // budget of three panels 8 columns wide, the last panel has 6 columns
+  auto budget = io::kPanelBuffers * kSize * sizeof(double) * 8;
+  auto path = tempPath();
+  auto file = io::writePanels(matrix::MatrixView<double>(m), path, budget);
+  ASSERT_EQ(file.panelWidth(), 8);
+  ASSERT_EQ(file.numPanels(), 9);
+  ASSERT_EQ(file.panelCols(8), 6);
+  EXPECT_NEAR(io::outOfCoreDet(file), expected, 1e-9 * std::abs(expected));
+
+  matrix::ThreadPool pool(2);
+  file = io::writePanels(matrix::MatrixView<double>(m).transposed(), path,
+                         budget);
+  EXPECT_NEAR(io::outOfCoreDet(file, &pool), expected,
+              1e-9 * std::abs(expected));
+
+  // text input is streamed by row blocks, file is read back by header
+  std::ostringstream text;
+  text << kSize << '\n';
+  for (auto elem : m) {
+    text << std::setprecision(17) << elem << ' ';
+  }
+  auto str = text.str();
+  io::TextParser parser(str);
+  io::writePanels(parser, path, budget);
+  auto reopened = io::PanelFile::open(path);
+  ASSERT_EQ(reopened.panelWidth(), 8);
+  EXPECT_NEAR(io::outOfCoreDet(reopened), expected,
+              1e-9 * std::abs(expected));
+
+  for (std::size_t j = 0; j < kSize; ++j) {
+    m[40][j] = m[3][j];
+  }
+  file = io::writePanels(matrix::MatrixView<double>(m), path, budget);
+  EXPECT_NEAR(io::outOfCoreDet(file), 0, 1e-9);
+
+  EXPECT_THROW(io::MappedMatrix::fromFile(path), std::runtime_error);
+  EXPECT_THROW(io::writePanels(matrix::MatrixView<double>(m), path, 100),
+               std::runtime_error);
+  {
+    std::ofstream os(path, std::ios::binary);
+    io::writeBinary(os, m);
+  }
+  EXPECT_THROW(io::PanelFile::open(path), std::runtime_error);
+  ::unlink(path.c_str());
+}
+
+int main(int argc, char** argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -1,7 +1,16 @@
+#include <cstdint>
+#include <random>
+#include <tuple>
 #include <stdexcept>
 
 #include "gtest/gtest.h"
+#include "matrix/big_int.hh"
+#include "matrix/fixed_matrix.hh"
 #include "matrix/matrix.hh"
+#include "matrix/matrix_view.hh"
+#include "matrix/sparse_matrix.hh"
+#include "matrix/structure.hh"
+#include "vector/stats.hh"
 
 TEST(matrix_ctor, simple) {
   // clang-format off
@@ -31,6 +40,25 @@ TEST(matrix_ctor, ilist) {
   ASSERT_TRUE(std::equal(v.begin(), v.end(), m.begin()));
 }
 
+TEST(matrix_ctor, aligned_storage) {
+  matrix::Matrix<double> m(3, 5);
+  ASSERT_EQ(reinterpret_cast<std::uintptr_t>(m.data()) %
+                vector::kCacheLineSize,
+            0);
+}
+
+TEST(matrix_ctor, small_inline) {
+  matrix::Matrix<double> small(3, 3, 1.0);
+  auto* obj = reinterpret_cast<const char*>(&small);
+  auto* elems = reinterpret_cast<const char*>(small.data());
+  ASSERT_TRUE(elems >= obj && elems < obj + sizeof(small));
+
+  auto moved = std::move(small);
+  ASSERT_EQ(moved[2][2], 1.0);
+  matrix::Matrix<double> scaled = matrix::Matrix<double>::eye(4) * 2.0;
+  ASSERT_TRUE(comparator::isClose(scaled.det(), 16.0));
+}
+
 TEST(det, simple) {
   // clang-format off
   std::vector<double> v{1,  2, 3,
@@ -110,6 +138,887 @@ TEST(det, integer_matrix) {
   ASSERT_TRUE(comparator::isClose(m3.det(), 4556.0));
 }
 
+namespace {
+
+matrix::Matrix<double> randomMatrix(std::size_t n, unsigned seed = 42) {
+  std::mt19937 gen(seed);
+  std::uniform_real_distribution<double> dist(-1.0, 1.0);
+  matrix::Matrix<double> m(n, n);
+  std::generate(m.begin(), m.end(), [&] { return dist(gen); });
+  return m;
+}
+
+}  // namespace
+
+TEST(lu, reconstruct) {
+  constexpr std::size_t n = 37;
+  auto a = randomMatrix(n);
+  matrix::LuOptions recursive;
+  recursive.algorithm = matrix::LuAlgorithm::kRecursive;
+  for (matrix::LuOptions opts : {matrix::LuOptions{1}, matrix::LuOptions{4},
+                                 matrix::LuOptions{16}, matrix::LuOptions{64},
+                                 recursive}) {
+    auto lu = a;
+    vector::Vector<std::size_t> perm;
+    ASSERT_TRUE(lu.luFactorize(perm, opts));
+
+    auto pa = a;
+    for (std::size_t i = 0; i < n; ++i) {
+      pa.swapRows(i, perm[i]);
+    }
+
+    for (std::size_t i = 0; i < n; ++i) {
+      for (std::size_t j = 0; j < n; ++j) {
+        auto sum = 0.0;
+        for (std::size_t k = 0; k <= std::min(i, j); ++k) {
+          sum += (k == i ? 1.0 : lu[i][k]) * lu[k][j];
+        }
+        ASSERT_TRUE(comparator::isClose(sum, pa[i][j], 1e-9));
+      }
+    }
+  }
+}
+
+TEST(det, block_size_independent) {
+  auto m = randomMatrix(150);
+  auto expected = m.det({1});
+  for (std::size_t block : {7, 32, 64, 200}) {
+    ASSERT_TRUE(comparator::isClose(m.det({block}), expected, 1e-9, 1e-9));
+  }
+}
+
+TEST(det, recursive_matches_blocked) {
+  matrix::ThreadPool pool(4);
+  matrix::LuOptions recursive;
+  recursive.algorithm = matrix::LuAlgorithm::kRecursive;
+  recursive.detect_structure = false;
+  for (std::size_t n : {1, 2, 16, 17, 33, 100, 257}) {
+    auto m = randomMatrix(n, static_cast<unsigned>(n));
+    auto expected = m.det({1});
+    ASSERT_TRUE(comparator::isClose(m.det(recursive), expected, 1e-9, 1e-9))
+        << n;
+  }
+
+  // singular: row 40 duplicates row 3
+  auto m = randomMatrix(120, 5);
+  std::copy(m[3].cbegin(), m[3].cend(), m[40].begin());
+  ASSERT_EQ(m.det(recursive), 0);
+
+  auto serial = randomMatrix(300, 9);
+  auto parallel = serial;
+  vector::Vector<std::size_t> serial_perm;
+  vector::Vector<std::size_t> parallel_perm;
+  serial.luFactorize(serial_perm, recursive);
+  recursive.pool = &pool;
+  parallel.luFactorize(parallel_perm, recursive);
+  ASSERT_TRUE(std::equal(serial.cbegin(), serial.cend(), parallel.cbegin()));
+}
+
+TEST(lu, fused_pivot_search) {
+  constexpr std::size_t n = 60;
+  auto m = randomMatrix(n, 4);
+  auto expected = m.det();
+
+  // pivot-by-pivot elimination driven by pivots simplifyRows() returns
+  auto work = m;
+  auto det = 1.0;
+  auto p = matrix::detail::findPivot(work.data(), n, 0, 0, n);
+  for (std::size_t i = 0; i < n; ++i) {
+    if (work.swapRows(i, p)) {
+      det = -det;
+    }
+    det *= work[i][i];
+    auto next = work.simplifyRows(i);
+    if (i + 1 < n) {
+      ASSERT_EQ(next, matrix::detail::findPivot(work.data(), n, i + 1, i + 1,
+                                                n));
+    } else {
+      ASSERT_EQ(next, n);
+    }
+    p = next;
+  }
+  ASSERT_TRUE(comparator::isClose(det, expected, 1e-9, 1e-9));
+
+  // ties go to the first row, as with separate scan
+  matrix::Matrix<double> ties(3, 3, std::initializer_list<double>{
+                                        1, 0, 0, 1, 2, 0, 1, -2, 1}.begin());
+  ASSERT_EQ(ties.simplifyRows(0), 1);
+}
+
+TEST(thread_pool, parallel_for) {
+  matrix::ThreadPool pool(4);
+  std::vector<int> hits(1000);
+  pool.parallelFor(0, hits.size(), 10, [&](std::size_t b, std::size_t e) {
+    for (auto i = b; i < e; ++i) {
+      ++hits[i];
+    }
+  });
+  ASSERT_TRUE(
+      std::all_of(hits.begin(), hits.end(), [](int h) { return h == 1; }));
+
+  auto fut = pool.submit([] { return 42; });
+  ASSERT_EQ(fut.get(), 42);
+
+  ASSERT_THROW(pool.parallelFor(0, 100, 1,
+                                [](std::size_t, std::size_t) {
+                                  throw std::runtime_error("fail");
+                                }),
+               std::runtime_error);
+}
+
+TEST(lu, parallel_matches_serial) {
+  constexpr std::size_t n = 400;
+  auto serial = randomMatrix(n, 7);
+  auto parallel = serial;
+  matrix::ThreadPool pool(4);
+
+  vector::Vector<std::size_t> serial_perm;
+  vector::Vector<std::size_t> parallel_perm;
+  serial.luFactorize(serial_perm, {64});
+  parallel.luFactorize(parallel_perm, {64, &pool});
+
+  ASSERT_TRUE(std::equal(serial_perm.cbegin(), serial_perm.cend(),
+                         parallel_perm.cbegin()));
+  ASSERT_TRUE(std::equal(serial.cbegin(), serial.cend(), parallel.cbegin()));
+}
+
+template <typename T>
+void checkAxpyKernels() {
+  using namespace matrix::detail::simd;
+  std::mt19937 gen(1);
+  std::uniform_real_distribution<T> dist(-1, 1);
+  for (auto isa : {Isa::kSse2, Isa::kAvx2, Isa::kAvx512}) {
+    if (!isSupported(isa)) {
+      continue;
+    }
+    auto kernel = axpyKernel<T>(isa);
+    for (std::size_t n = 0; n < 70; ++n) {
+      std::vector<T> x(n);
+      std::vector<T> y(n);
+      std::generate(x.begin(), x.end(), [&] { return dist(gen); });
+      std::generate(y.begin(), y.end(), [&] { return dist(gen); });
+      auto expected = y;
+      axpyScalar(expected.data(), x.data(), n, T{-0.5});
+      kernel(y.data(), x.data(), n, T{-0.5});
+      for (std::size_t i = 0; i < n; ++i) {
+        ASSERT_TRUE(comparator::isClose<T>(y[i], expected[i], 1e-6, 1e-6));
+      }
+    }
+  }
+}
+
+TEST(simd, axpy_kernels) {
+  checkAxpyKernels<double>();
+  checkAxpyKernels<float>();
+}
+
+template <typename T>
+matrix::Matrix<T> naiveProduct(const matrix::Matrix<T>& a,
+                               const matrix::Matrix<T>& b) {
+  matrix::Matrix<T> c(a.rows(), b.cols());
+  for (std::size_t i = 0; i < a.rows(); ++i) {
+    for (std::size_t j = 0; j < b.cols(); ++j) {
+      for (std::size_t k = 0; k < a.cols(); ++k) {
+        c[i][j] += a[i][k] * b[k][j];
+      }
+    }
+  }
+  return c;
+}
+
+template <typename T>
+void checkProduct(std::size_t m, std::size_t k, std::size_t n) {
+  std::mt19937 gen(m * n * k);
+  std::uniform_int_distribution<int> dist(-5, 5);
+  matrix::Matrix<T> a(m, k);
+  matrix::Matrix<T> b(k, n);
+  std::generate(a.begin(), a.end(), [&] { return dist(gen); });
+  std::generate(b.begin(), b.end(), [&] { return dist(gen); });
+
+  auto c = a * b;
+  auto expected = naiveProduct(a, b);
+  ASSERT_EQ(c.rows(), m);
+  ASSERT_EQ(c.cols(), n);
+  // small integers are represented exactly
+  ASSERT_TRUE(std::equal(c.cbegin(), c.cend(), expected.cbegin()));
+}
+
+TEST(gemm, matches_naive) {
+  for (auto [m, k, n] : {std::tuple{1, 1, 1}, {5, 7, 3}, {4, 8, 16},
+                         {130, 257, 70}, {33, 300, 129}}) {
+    checkProduct<double>(m, k, n);
+    checkProduct<float>(m, k, n);
+    checkProduct<int>(m, k, n);
+  }
+}
+
+TEST(gemm, size_mismatch) {
+  matrix::Matrix<double> a(2, 3);
+  matrix::Matrix<double> b(2, 3);
+  ASSERT_THROW(a * b, std::runtime_error);
+}
+
+TEST(gemv, simple) {
+  auto il = {1, 2, 3, 4, 5, 6};
+  matrix::Matrix<int> m(2, 3, il.begin());
+  vector::Vector<int> v{1, 0, -1};
+  auto res = m * v;
+  ASSERT_EQ(res.size(), 2);
+  ASSERT_EQ(res[0], -2);
+  ASSERT_EQ(res[1], -2);
+}
+
+TEST(expression, fused) {
+  auto il_a = {1.0, 2.0, 3.0, 4.0};
+  auto il_b = {0.5, 0.5, 1.0, 1.0};
+  auto il_c = {1.0, 1.0, 1.0, 1.0};
+  matrix::Matrix<double> a(2, 2, il_a.begin());
+  matrix::Matrix<double> b(2, 2, il_b.begin());
+  matrix::Matrix<double> c(2, 2, il_c.begin());
+
+  matrix::Matrix<double> d = a + 2 * b - c;
+  std::vector<double> expected{1.0, 2.0, 4.0, 5.0};
+  ASSERT_TRUE(std::equal(d.cbegin(), d.cend(), expected.begin()));
+
+  d = -(d / 2.0) + a * 0.5;
+  std::vector<double> expected2{0.0, -0.0, -0.5, -0.5};
+  ASSERT_TRUE(std::equal(d.cbegin(), d.cend(), expected2.begin()));
+}
+
+TEST(expression, compound_and_aliasing) {
+  auto il = {1, 2, 3, 4, 5, 6};
+  matrix::Matrix<int> a(2, 3, il.begin());
+  auto b = a;
+  a += a + b;
+  a -= b;
+  a *= 3;
+  std::vector<int> expected{6, 12, 18, 24, 30, 36};
+  ASSERT_TRUE(std::equal(a.cbegin(), a.cend(), expected.begin()));
+
+  matrix::Matrix<double> mixed = a + 0.5 * b;
+  ASSERT_EQ(mixed[1][2], 39.0);
+}
+
+TEST(expression, size_mismatch) {
+  matrix::Matrix<double> a(2, 3);
+  matrix::Matrix<double> b(3, 2);
+  ASSERT_THROW(a + b, std::runtime_error);
+}
+
+TEST(fixed_matrix, constexpr_det) {
+  constexpr matrix::FixedMatrix<int, 2, 2> m2{1, 2, 2, 1};
+  static_assert(m2.det() == -3.0);
+
+  constexpr matrix::FixedMatrix<double, 3, 3> m3{1, 2, 3, 4, 5, 6, 7, 87, 9};
+  static_assert(m3.det() == 474.0);
+
+  constexpr auto m5 = matrix::FixedMatrix<double, 5, 5>::eye() * 2.0;
+  static_assert(m5.det() == 32.0);
+}
+
+template <std::size_t N>
+void checkFixedDet() {
+  auto dynamic = randomMatrix(N, N);
+  matrix::FixedMatrix<double, N, N> fixed(dynamic);
+  ASSERT_TRUE(comparator::isClose(fixed.det(), dynamic.det(), 1e-12));
+}
+
+TEST(fixed_matrix, det_matches_dynamic) {
+  checkFixedDet<1>();
+  checkFixedDet<2>();
+  checkFixedDet<3>();
+  checkFixedDet<4>();
+  checkFixedDet<5>();
+  checkFixedDet<8>();
+}
+
+TEST(fixed_matrix, constructors) {
+  matrix::FixedMatrix<double, 2, 2> zero = {};
+  ASSERT_EQ(zero[1][1], 0.0);
+  matrix::FixedMatrix<double, 2, 2> filled(1.5);
+  ASSERT_EQ(filled[1][0], 1.5);
+  // braces select the list constructor
+  matrix::FixedMatrix<double, 2, 2> first{1.5};
+  ASSERT_EQ(first[0][0], 1.5);
+  ASSERT_EQ(first[1][0], 0.0);
+}
+
+TEST(fixed_matrix, singular_det_is_zero) {
+  // closed form leaves rounding noise of about 1e-17
+  matrix::FixedMatrix<double, 3, 3> m3{0.1, 0.2, 0.3, 0.4, 0.5,
+                                       0.6, 0.7, 0.8, 0.9};
+  ASSERT_EQ(m3.det(), 0.0);
+  ASSERT_EQ(static_cast<matrix::Matrix<double>>(m3).det(), 0.0);
+
+  matrix::FixedMatrix<double, 5, 5> m5;
+  for (std::size_t i = 0; i < 5; ++i) {
+    for (std::size_t j = 0; j < 5; ++j) {
+      m5[i][j] = 0.1 * static_cast<double>(i * 5 + j + 1);
+    }
+  }
+  ASSERT_EQ(m5.det(), 0.0);
+}
+
+TEST(fixed_matrix, arithmetic) {
+  constexpr matrix::FixedMatrix<int, 2, 3> a{1, 2, 3, 4, 5, 6};
+  constexpr auto at = a.transposed();
+  constexpr auto prod = a * at;
+  static_assert(prod == matrix::FixedMatrix<int, 2, 2>{14, 32, 32, 77});
+  static_assert(a + a == 2 * a);
+  static_assert(a - a == matrix::FixedMatrix<int, 2, 3>());
+
+  auto dynamic = static_cast<matrix::Matrix<int>>(a);
+  ASSERT_EQ(dynamic.rows(), 2);
+  ASSERT_EQ(dynamic[1][2], 6);
+  ASSERT_THROW((matrix::FixedMatrix<int, 3, 3>(dynamic)), std::runtime_error);
+}
+
+TEST(workspace, reused_between_calls) {
+  matrix::Workspace ws;
+  matrix::LuOptions opts;
+  opts.workspace = &ws;
+
+  auto big = randomMatrix(64, 3);
+  auto expected = big.det();
+  ASSERT_TRUE(comparator::isClose(big.det(opts), expected));
+  auto capacity = ws.capacity();
+  auto* buf = ws.matrix(64, 64);
+  ASSERT_GT(capacity, 0);
+
+  auto small = randomMatrix(32, 4);
+  for (int i = 0; i < 3; ++i) {
+    ASSERT_TRUE(comparator::isClose(small.det(opts), small.det()));
+    ASSERT_TRUE(comparator::isClose(big.det(opts), expected));
+  }
+  ASSERT_EQ(ws.capacity(), capacity);
+  ASSERT_EQ(ws.matrix(64, 64), buf);
+
+  ws.release();
+  ASSERT_EQ(ws.capacity(), 0);
+}
+
+TEST(lu_object, solve_and_inverse) {
+  constexpr std::size_t n = 40;
+  auto a = randomMatrix(n, 5);
+  auto lu = a.lu();
+  ASSERT_FALSE(lu.isSingular());
+  ASSERT_TRUE(comparator::isClose(lu.det(), a.det(), 1e-9, 1e-9));
+  ASSERT_EQ(lu.rank(), n);
+
+  vector::Vector<double> b(n);
+  for (std::size_t i = 0; i < n; ++i) {
+    b[i] = static_cast<double>(i) - 3.0;
+  }
+  auto ax = a * lu.solve(b);
+  for (std::size_t i = 0; i < n; ++i) {
+    ASSERT_TRUE(comparator::isClose(ax[i], b[i], 1e-9, 1e-9));
+  }
+
+  auto prod = a * lu.inverse();
+  auto eye = matrix::Matrix<double>::eye(n);
+  for (std::size_t i = 0; i < n * n; ++i) {
+    ASSERT_NEAR(prod.cbegin()[i], eye.cbegin()[i], 1e-9);
+  }
+}
+
+TEST(lu_object, rvalue_reuses_storage) {
+  auto a = randomMatrix(20, 6);
+  auto expected = a.det();
+  const auto* storage = a.data();
+  auto lu = std::move(a).lu();
+  ASSERT_EQ(lu.packed().data(), storage);
+  ASSERT_TRUE(comparator::isClose(lu.det(), expected));
+}
+
+TEST(lu_object, singular_rank) {
+  // clang-format off
+  matrix::Matrix<int> m(4, 4, std::initializer_list<int>{1, 2, 3,  4,
+                                                         2, 4, 6,  8,
+                                                         0, 0, 1,  1,
+                                                         1, 2, 4,  5}.begin());
+  // clang-format on
+  auto lu = m.lu();
+  ASSERT_TRUE(lu.isSingular());
+  ASSERT_EQ(lu.det(), 0);
+  ASSERT_EQ(lu.rank(), 2);
+  ASSERT_THROW(lu.solve(vector::Vector<double>(4)), std::runtime_error);
+  ASSERT_EQ(matrix::Matrix<double>(3, 3).lu().rank(), 0);
+}
+
+TEST(matrix_view, det_with_stride) {
+  auto m = randomMatrix(12, 8);
+  matrix::Matrix<double> padded(12, 15, 100.0);
+  for (std::size_t i = 0; i < 12; ++i) {
+    std::copy(m[i].cbegin(), m[i].cend(), padded[i].begin());
+  }
+
+  matrix::MatrixView<double> view(padded.data(), 12, 12, 15);
+  ASSERT_TRUE(comparator::isClose(view.det(), m.det()));
+  ASSERT_TRUE(std::equal(m.cbegin(), m.cend(), view.toMatrix().cbegin()));
+  ASSERT_THROW(matrix::MatrixView<double>(padded).det(), std::runtime_error);
+}
+
+TEST(matrix_view, slicing) {
+  // clang-format off
+  std::initializer_list<int> il{1,  2,  3,  4,
+                                5,  6,  7,  8,
+                                9, 10, 11, 12};
+  // clang-format on
+  matrix::Matrix<int> m(3, 4, il.begin());
+  matrix::MatrixView<int> v(m);
+  auto sub = v.submatrix(1, 1, 2, 3);
+  ASSERT_EQ(sub(0, 0), 6);
+  ASSERT_EQ(sub[1][2], 12);
+  ASSERT_THROW(v.submatrix(1, 2, 3, 1), std::runtime_error);
+
+  auto t = v.transposed();
+  ASSERT_EQ(t.rows(), 4);
+  ASSERT_EQ(t(3, 1), 8);
+  ASSERT_TRUE(t.isColMajor());
+  ASSERT_EQ(t.submatrix(1, 0, 2, 2).transposed()(1, 0), 6);
+
+  auto col = v.col(2);
+  ASSERT_EQ(col.size(), 3);
+  ASSERT_EQ(col.stride(), 4);
+  ASSERT_EQ(col[2], 11);
+  auto copy = col.toVector();
+  ASSERT_EQ(copy[1], 7);
+
+  auto tm = t.toMatrix<double>();
+  ASSERT_EQ(tm[2][1], 7.0);
+}
+
+TEST(matrix_view, routines_accept_views) {
+  auto big = randomMatrix(50, 9);
+  matrix::MatrixView<double> v(big);
+  auto block = v.submatrix(10, 20, 25, 25);
+  auto copy = block.toMatrix();
+  ASSERT_TRUE(comparator::isClose(block.det(), copy.det()));
+  ASSERT_TRUE(comparator::isClose(block.transposed().det(), copy.det()));
+  ASSERT_TRUE(comparator::isClose(block.lu().det(), copy.det()));
+
+  // neither rows nor columns are contiguous
+  matrix::MatrixView<double> sparse(big.data(), 25, 25, 100, 2);
+  ASSERT_TRUE(
+      comparator::isClose(sparse.det(), sparse.toMatrix().det(), 1e-9, 1e-9));
+
+  auto prod = block.transposed() * v.submatrix(0, 0, 25, 7);
+  auto expected = block.transposed().toMatrix() *
+                  v.submatrix(0, 0, 25, 7).toMatrix();
+  for (std::size_t i = 0; i < prod.rows() * prod.cols(); ++i) {
+    ASSERT_NEAR(prod.cbegin()[i], expected.cbegin()[i], 1e-12);
+  }
+
+  auto x = v.submatrix(0, 3, 25, 1).col(0);
+  auto y = block * x.toVector();
+  auto y_strided = block * x;
+  auto y_expected = copy * x.toVector();
+  for (std::size_t i = 0; i < 25; ++i) {
+    ASSERT_NEAR(y[i], y_expected[i], 1e-12);
+    ASSERT_NEAR(y_strided[i], y_expected[i], 1e-12);
+  }
+
+  matrix::Matrix<long long> ints(3, 3);
+  ints[0][1] = 2;
+  ints[1][2] = 3;
+  ints[2][0] = 4;
+  ASSERT_EQ(matrix::MatrixView<long long>(ints).transposed().exactDet(),
+            matrix::BigInt(24));
+}
+
+TEST(sparse_matrix, conversions) {
+  std::vector<matrix::Triplet<int>> triplets{
+      {2, 1, 5}, {0, 0, 1}, {2, 1, -2}, {1, 2, 4}, {0, 2, 3}, {1, 0, 7},
+      {1, 0, -7}};
+  matrix::SparseMatrix<int> s(3, 3, triplets.begin(), triplets.end());
+  ASSERT_EQ(s.nnz(), 4);  // duplicates summed, cancelled entry dropped
+  ASSERT_EQ(s.at(2, 1), 3);
+  ASSERT_EQ(s.at(1, 0), 0);
+
+  auto dense = s.toDense();
+  ASSERT_EQ(dense[0][2], 3);
+  ASSERT_EQ(dense[1][2], 4);
+  matrix::SparseMatrix<int> back(dense);
+  ASSERT_TRUE(std::equal(back.values().cbegin(), back.values().cend(),
+                         s.values().cbegin()));
+
+  auto t = s.transposed();
+  ASSERT_EQ(t.at(1, 2), 3);
+  ASSERT_EQ(t.at(2, 0), 3);
+  ASSERT_EQ(t.transposed().toDense()[1][2], 4);
+
+  std::vector<matrix::Triplet<int>> bad{{3, 0, 1}};
+  ASSERT_THROW(matrix::SparseMatrix<int>(3, 3, bad.begin(), bad.end()),
+               std::runtime_error);
+}
+
+TEST(sparse_lu, det_matches_dense) {
+  std::mt19937 gen(7);
+  std::uniform_real_distribution<double> dist(-1.0, 1.0);
+  std::uniform_int_distribution<std::size_t> pos(0, 59);
+  for (auto ordering :
+       {matrix::SparseOrdering::kNatural, matrix::SparseOrdering::kMinDegree}) {
+    for (int trial = 0; trial < 5; ++trial) {
+      // diagonal keeps the matrix nonsingular, off-diagonal entries fill in
+      std::vector<matrix::Triplet<double>> triplets;
+      for (std::size_t i = 0; i < 60; ++i) {
+        triplets.push_back({i, i, 2.0 + dist(gen)});
+      }
+      for (int k = 0; k < 180; ++k) {
+        triplets.push_back({pos(gen), pos(gen), dist(gen)});
+      }
+
+      matrix::SparseMatrix<double> s(60, 60, triplets.begin(),
+                                     triplets.end());
+      matrix::SparseLuOptions opts;
+      opts.ordering = ordering;
+      auto lu = s.lu(opts);
+      auto expected = s.toDense().det();
+      ASSERT_FALSE(lu.isSingular());
+      ASSERT_TRUE(comparator::isClose(lu.det(), expected, 1e-9, 1e-9));
+
+      vector::Vector<double> b(60);
+      for (std::size_t i = 0; i < 60; ++i) {
+        b[i] = dist(gen);
+      }
+      auto ax = s * lu.solve(b);
+      for (std::size_t i = 0; i < 60; ++i) {
+        ASSERT_NEAR(ax[i], b[i], 1e-9);
+      }
+    }
+  }
+}
+
+TEST(sparse_lu, pivoting_and_singular) {
+  // zero diagonal requires row exchanges
+  std::vector<matrix::Triplet<int>> perm{{0, 1, 2}, {1, 2, 3}, {2, 0, 4}};
+  matrix::SparseMatrix<int> p(3, 3, perm.begin(), perm.end());
+  ASSERT_TRUE(comparator::isClose(p.det(), 24.0));
+
+  std::vector<matrix::Triplet<int>> dup{
+      {0, 0, 1}, {0, 1, 2}, {1, 0, 2}, {1, 1, 4}, {2, 2, 1}};
+  matrix::SparseMatrix<int> s(3, 3, dup.begin(), dup.end());
+  auto lu = s.lu();
+  ASSERT_TRUE(lu.isSingular());
+  ASSERT_EQ(lu.det(), 0);
+  ASSERT_THROW(lu.solve(vector::Vector<double>(3)), std::runtime_error);
+
+  ASSERT_EQ(matrix::SparseMatrix<double>(4, 4).det(), 0);
+  ASSERT_THROW(matrix::SparseMatrix<double>(3, 4).det(), std::runtime_error);
+}
+
+TEST(sparse_lu, tridiagonal_has_no_fill) {
+  constexpr std::size_t n = 1000;
+  std::vector<matrix::Triplet<double>> triplets;
+  for (std::size_t i = 0; i < n; ++i) {
+    triplets.push_back({i, i, 2.0});
+    if (i + 1 < n) {
+      triplets.push_back({i, i + 1, -1.0});
+      triplets.push_back({i + 1, i, -1.0});
+    }
+  }
+  matrix::SparseMatrix<double> s(n, n, triplets.begin(), triplets.end());
+  auto lu = s.lu();
+  // det of 1D Laplacian is n + 1
+  ASSERT_TRUE(comparator::isClose(lu.det(), n + 1.0, 1e-9, 1e-9));
+  ASSERT_LE(lu.nnzL() + lu.nnzU(), 2 * s.nnz() + 2 * n);
+}
+
+namespace {
+
+/** Random matrix with elements outside of the band [i - kl, i + ku] zeroed */
+matrix::Matrix<double> bandMatrix(std::size_t n, std::size_t kl,
+                                  std::size_t ku, unsigned seed) {
+  auto m = randomMatrix(n, seed);
+  for (std::size_t i = 0; i < n; ++i) {
+    for (std::size_t j = 0; j < n; ++j) {
+      if (i > j + kl || j > i + ku) {
+        m[i][j] = 0;
+      }
+    }
+  }
+  return m;
+}
+
+double luOnlyDet(const matrix::Matrix<double>& m) {
+  matrix::LuOptions opts;
+  opts.detect_structure = false;
+  return m.det(opts);
+}
+
+}  // namespace
+
+TEST(structure, analyze) {
+  auto upper = bandMatrix(10, 0, 9, 1);
+  auto s = matrix::analyzeStructure(upper.data(), 10, 10);
+  ASSERT_TRUE(s.isUpperTriangular());
+  ASSERT_FALSE(s.isDiagonal());
+  ASSERT_EQ(s.numBlocks(), 1);
+
+  auto band = bandMatrix(40, 2, 3, 2);
+  s = matrix::analyzeStructure(band.data(), 40, 40);
+  ASSERT_EQ(s.lower_bandwidth, 2);
+  ASSERT_EQ(s.upper_bandwidth, 3);
+  ASSERT_TRUE(s.isBanded());
+  ASSERT_FALSE(s.isTriangular());
+
+  // blocks [0, 3), [3, 4), [4, 6)
+  // clang-format off
+  matrix::Matrix<int> blocks(6, 6, std::initializer_list<int>{
+      1, 2, 0, 0, 0, 0,
+      0, 1, 3, 0, 0, 0,
+      4, 0, 1, 0, 0, 0,
+      0, 0, 0, 5, 0, 0,
+      0, 0, 0, 0, 1, 2,
+      0, 0, 0, 0, 3, 1}.begin());
+  // clang-format on
+  s = matrix::analyzeStructure(blocks.data(), 6, 6);
+  ASSERT_TRUE(s.isBlockDiagonal());
+  std::vector<std::size_t> expected_blocks{0, 3, 4, 6};
+  ASSERT_EQ(std::vector<std::size_t>(s.blocks.cbegin(), s.blocks.cend()),
+            expected_blocks);
+  ASSERT_EQ(blocks.det(), 25 * 5 * -5);
+
+  blocks[3][3] = 0;
+  ASSERT_TRUE(matrix::analyzeStructure(blocks.data(), 6, 6).has_zero_row);
+  ASSERT_EQ(blocks.det(), 0);
+}
+
+TEST(structure, det_fast_paths) {
+  for (auto [kl, ku] : {std::pair<std::size_t, std::size_t>{0, 199},
+                        {199, 0},
+                        {0, 0},
+                        {3, 2},
+                        {1, 10},
+                        {12, 0}}) {
+    auto m = bandMatrix(200, kl, ku, static_cast<unsigned>(kl * 7 + ku));
+    ASSERT_TRUE(comparator::isClose(m.det(), luOnlyDet(m), 1e-9, 1e-9))
+        << kl << " " << ku;
+  }
+
+  // singular band matrix
+  auto m = bandMatrix(100, 2, 2, 3);
+  m[50][48] = m[50][49] = m[50][50] = m[50][51] = m[50][52] = 0;
+  ASSERT_EQ(m.det(), 0);
+}
+
+TEST(structure, block_diagonal_parallel) {
+  constexpr std::size_t n = 280;  // blocks of sizes 10, 20, ..., 70
+  matrix::Matrix<double> m(n, n);
+  for (std::size_t offset = 0, size = 10; offset < n;
+       offset += size, size += 10) {
+    auto block = randomMatrix(size, static_cast<unsigned>(size));
+    for (std::size_t i = 0; i < size; ++i) {
+      std::copy(block[i].cbegin(), block[i].cend(),
+                m[offset + i].begin() + offset);
+    }
+  }
+
+  matrix::ThreadPool pool(4);
+  matrix::LuOptions opts;
+  opts.pool = &pool;
+  auto expected = luOnlyDet(m);
+  ASSERT_TRUE(comparator::isClose(m.det(), expected, 1e-9, 1e-9));
+  ASSERT_TRUE(comparator::isClose(m.det(opts), expected, 1e-9, 1e-9));
+}
+
+TEST(structure, block_diagonal_uneven) {
+  // decoupled first row and column, the big block takes parallel LU
+  constexpr std::size_t n = 300;
+  auto block = randomMatrix(n - 1, 3);
+  matrix::Matrix<double> m(n, n);
+  m[0][0] = 2;
+  for (std::size_t i = 0; i + 1 < n; ++i) {
+    std::copy(block[i].cbegin(), block[i].cend(), m[i + 1].begin() + 1);
+  }
+
+  matrix::ThreadPool pool(4);
+  matrix::LuOptions opts;
+  opts.pool = &pool;
+  auto expected = 2 * luOnlyDet(block);
+  ASSERT_TRUE(comparator::isClose(m.det(opts), expected, 1e-9, 1e-9));
+}
+
+TEST(big_int, conversions) {
+  ASSERT_EQ(matrix::BigInt().toString(), "0");
+  ASSERT_EQ(matrix::BigInt(-42).toString(), "-42");
+  ASSERT_EQ(matrix::BigInt(std::numeric_limits<long long>::min()).toString(),
+            "-9223372036854775808");
+
+  // 10^40 crosses both limb and 19-digit chunk boundaries
+  matrix::BigInt big(1);
+  for (int i = 0; i < 40; ++i) {
+    big.mulAdd(10, 0);
+  }
+  ASSERT_EQ(big.toString(), "1" + std::string(40, '0'));
+  ASSERT_EQ(big.bitLength(), 133);
+  ASSERT_DOUBLE_EQ(big.toDouble(), 1e40);
+  ASSERT_EQ((-big).toString(), "-1" + std::string(40, '0'));
+  ASSERT_NE(big, -big);
+  ASSERT_EQ(matrix::BigInt::fromParts(true, 0, 7), matrix::BigInt(-7));
+}
+
+TEST(modular, montgomery) {
+  ASSERT_TRUE(matrix::detail::isPrime(2305843009213693951ull));  // 2^61 - 1
+  ASSERT_FALSE(matrix::detail::isPrime(3215031751ull));  // strong pseudoprime
+  const auto& primes = matrix::detail::modularPrimes(3);
+  ASSERT_LT(primes[0], 1ull << 62);
+  ASSERT_GT(primes[0], primes[1]);
+
+  matrix::detail::Montgomery mg(primes[0]);
+  std::mt19937_64 gen(1);
+  for (int i = 0; i < 1000; ++i) {
+    auto a = gen() % primes[0];
+    auto b = gen() % primes[0];
+    auto prod = mg.fromMont(mg.mul(mg.toMont(a), mg.toMont(b)));
+    ASSERT_EQ(prod, matrix::detail::mulMod(a, b, primes[0]));
+  }
+  auto x = mg.toMont(12345);
+  ASSERT_EQ(mg.fromMont(mg.mul(x, mg.inverse(x))), 1);
+}
+
+TEST(exact_det, small_bareiss) {
+  matrix::Matrix<int> m(3, 3, std::initializer_list<int>{
+                                  2, -3, 1, 2, 0, -1, 1, 4, 5}.begin());
+  ASSERT_EQ(m.exactDet(), matrix::BigInt(49));
+  ASSERT_EQ(matrix::Matrix<int>(3, 3).exactDet(), matrix::BigInt());
+  ASSERT_THROW(matrix::Matrix<int>(2, 3).exactDet(), std::runtime_error);
+}
+
+TEST(exact_det, multimodular) {
+  // A = P * L * U with unit lower L, so det A = -prod of diagonal of U
+  constexpr std::size_t n = 30;
+  std::mt19937 gen(3);
+  std::uniform_int_distribution<long long> small(-3, 3);
+  std::uniform_int_distribution<long long> diag(2, 9);
+  matrix::Matrix<long long> l = matrix::Matrix<long long>::eye(n);
+  matrix::Matrix<long long> u(n, n);
+  matrix::BigInt expected(-1);
+  for (std::size_t i = 0; i < n; ++i) {
+    for (std::size_t j = 0; j < i; ++j) {
+      l[i][j] = small(gen);
+      u[j][i] = small(gen);
+    }
+    u[i][i] = diag(gen);
+    expected.mulAdd(static_cast<std::uint64_t>(u[i][i]), 0);
+  }
+  auto a = l * u;
+  a.swapRows(0, n - 1);
+  ASSERT_EQ(a.exactDet(), expected);
+
+  matrix::ThreadPool pool(3);
+  ASSERT_EQ(a.exactDet(&pool), expected);
+
+  // CRT path with zero result
+  std::copy(a[1].cbegin(), a[1].cend(), a[2].begin());
+  ASSERT_EQ(a.exactDet(&pool), matrix::BigInt());
+
+  // product of huge diagonal overflows any machine integer
+  matrix::Matrix<long long> d(3, 3);
+  d[0][1] = d[1][0] = d[2][2] = 1'000'000'000'000'000'000;
+  ASSERT_EQ(d.exactDet().toString(), "-1" + std::string(54, '0'));
+}
+
+TEST(layout, offsets) {
+  using Tile = matrix::TileMajor<4>;
+  ASSERT_EQ(matrix::RowMajor::offset(2, 3, 5, 7), 17);
+  ASSERT_EQ(matrix::ColMajor::offset(2, 3, 5, 7), 17);
+  ASSERT_EQ(Tile::storageSize(5, 7), 64);
+  ASSERT_EQ(Tile::offset(0, 3, 5, 7), 3);
+  ASSERT_EQ(Tile::offset(1, 0, 5, 7), 4);
+  ASSERT_EQ(Tile::offset(0, 4, 5, 7), 16);
+  ASSERT_EQ(Tile::offset(4, 0, 5, 7), 32);
+  ASSERT_EQ(Tile::offset(4, 6, 5, 7), 50);
+}
+
+TEST(layout, conversions) {
+  constexpr std::size_t rows = 37;
+  constexpr std::size_t cols = 45;
+  matrix::Matrix<int> m(rows, cols);
+  for (std::size_t i = 0; i < rows; ++i) {
+    for (std::size_t j = 0; j < cols; ++j) {
+      m[i][j] = static_cast<int>(i * 100 + j);
+    }
+  }
+
+  auto check = [&](const auto& other) {
+    ASSERT_EQ(other.rows(), rows);
+    ASSERT_EQ(other.cols(), cols);
+    for (std::size_t i = 0; i < rows; ++i) {
+      for (std::size_t j = 0; j < cols; ++j) {
+        ASSERT_EQ(other(i, j), m[i][j]) << i << " " << j;
+      }
+    }
+  };
+
+  matrix::Matrix<int, matrix::ColMajor> col(m);
+  matrix::Matrix<double, matrix::TileMajor<>> tile(m);
+  matrix::Matrix<int, matrix::TileMajor<8>> small_tile(col);
+  check(col);
+  check(tile);
+  check(small_tile);
+  check(matrix::Matrix<int>(col));
+  check(matrix::Matrix<int>(tile));
+  check(matrix::Matrix<int, matrix::ColMajor>(small_tile));
+  ASSERT_EQ(col.data()[1], m[1][0]);
+
+  // padding of partial tiles stays zero
+  ASSERT_EQ(std::count(tile.cbegin(), tile.cend(), 0.0),
+            64 * 64 - rows * cols + 1);
+
+  std::vector<int> seq(m.cbegin(), m.cend());
+  check(matrix::Matrix<int, matrix::TileMajor<16>>(rows, cols, seq.begin()));
+}
+
+TEST(layout, computations) {
+  auto m = randomMatrix(70, 11);
+  matrix::Matrix<double, matrix::ColMajor> col(m);
+  matrix::Matrix<double, matrix::TileMajor<>> tile(m);
+  ASSERT_TRUE(comparator::isClose(col.det(), m.det()));
+  ASSERT_TRUE(comparator::isClose(tile.det(), m.det()));
+  ASSERT_TRUE(comparator::isClose(col.lu().det(), m.det()));
+  ASSERT_TRUE(comparator::isClose(
+      matrix::MatrixView<double>(col).submatrix(5, 5, 30, 30).det(),
+      matrix::MatrixView<double>(m).submatrix(5, 5, 30, 30).det()));
+
+  auto expected = m * m;
+  auto prod = col * m;
+  auto prod_col = col * col;
+  for (std::size_t i = 0; i < 70 * 70; ++i) {
+    ASSERT_NEAR(prod.cbegin()[i], expected.cbegin()[i], 1e-12);
+    ASSERT_NEAR(prod_col.cbegin()[i], expected.cbegin()[i], 1e-12);
+  }
+
+  col.swapRows(0, 69);
+  ASSERT_EQ(col(0, 3), m[69][3]);
+  ASSERT_TRUE(comparator::isClose(col.det(), -m.det()));
+
+  auto eye = matrix::Matrix<int, matrix::TileMajor<>>::eye(40);
+  ASSERT_EQ(eye(39, 39), 1);
+  ASSERT_EQ(eye(39, 38), 0);
+  ASSERT_EQ(eye.det(), 1);
+  ASSERT_EQ(eye.exactDet(), matrix::BigInt(1));
+}
+
+TEST(stats, det_phases) {
+  using vector::stats::Phase;
+  auto m = randomMatrix(100, 3);
+  vector::stats::reset();
+  m.det();
+  auto s = vector::stats::snapshot();
+  if constexpr (vector::stats::kEnabled) {
+    ASSERT_NEAR(s.flops, 2.0 / 3 * 100 * 100 * 100, 1);
+    ASSERT_GT(s.phaseSeconds(Phase::kConvert), 0);
+    ASSERT_GT(s.phaseSeconds(Phase::kPivotSearch), 0);
+    ASSERT_GT(s.phaseSeconds(Phase::kRowSwap), 0);
+    ASSERT_GT(s.phaseSeconds(Phase::kElimination), 0);
+    ASSERT_GT(s.gflops(), 0);
+  } else {
+    ASSERT_EQ(s.flops, 0);
+    ASSERT_EQ(s.factorizationSeconds(), 0);
+  }
+}
+
 int main(int argc, char** argv) {
   ::testing::InitGoogleTest(&argc, argv);
   return RUN_ALL_TESTS();
@@ -1,8 +1,16 @@
 #include <algorithm>
+#include <cstdint>
+#include <iterator>
 #include <list>
+#include <numeric>
+#include <sstream>
+#include <string>
+#include <utility>
 #include <vector>
 
 #include "gtest/gtest.h"
+#include "vector/aligned_allocator.hh"
+#include "vector/stats.hh"
 #include "vector/vector.hh"
 
 TEST(vector, size_constructor) {
@@ -57,6 +65,208 @@ TEST(vector, reserve) {
   ASSERT_TRUE(std::equal(vv.rbegin(), vv.rend(), stdvv.rbegin()));
 }
 
+namespace {
+
+struct AllocStats {
+  std::size_t allocated = 0;
+  std::size_t deallocated = 0;
+};
+
+template <typename T>
+struct CountingAllocator {
+  using value_type = T;
+
+  explicit CountingAllocator(AllocStats* stats) noexcept : stats(stats) {}
+
+  template <typename U>
+  CountingAllocator(const CountingAllocator<U>& other) noexcept
+      : stats(other.stats) {}
+
+  T* allocate(std::size_t n) {
+    stats->allocated += n;
+    return std::allocator<T>().allocate(n);
+  }
+
+  void deallocate(T* p, std::size_t n) noexcept {
+    stats->deallocated += n;
+    std::allocator<T>().deallocate(p, n);
+  }
+
+  bool operator==(const CountingAllocator& rhs) const noexcept {
+    return stats == rhs.stats;
+  }
+  bool operator!=(const CountingAllocator& rhs) const noexcept {
+    return stats != rhs.stats;
+  }
+
+  AllocStats* stats;
+};
+
+}  // namespace
+
+TEST(vector, custom_allocator) {
+  AllocStats stats;
+  {
+    CountingAllocator<int> alloc(&stats);
+    vector::Vector<int, CountingAllocator<int>> v(10, 1, alloc);
+    for (int i = 0; i < 100; ++i) {
+      v.push_back(i);
+    }
+    auto copy = v;
+    ASSERT_EQ(copy.get_allocator(), alloc);
+    ASSERT_TRUE(std::equal(v.cbegin(), v.cend(), copy.cbegin()));
+
+    auto moved = std::move(copy);
+    copy = moved;
+  }
+  ASSERT_GT(stats.allocated, 0);
+  ASSERT_EQ(stats.allocated, stats.deallocated);
+}
+
+TEST(vector, aligned_allocator) {
+  vector::Vector<double, vector::AlignedAllocator<double, 64>> v(3, 1.0);
+  for (int i = 0; i < 1000; ++i) {
+    v.push_back(i);
+    ASSERT_EQ(reinterpret_cast<std::uintptr_t>(v.data()) % 64, 0);
+  }
+}
+
+TEST(vector, empty_and_back) {
+  vector::Vector<int> v;
+  ASSERT_TRUE(v.empty());
+  v.push_back(1);
+  v.push_back(2);
+  ASSERT_FALSE(v.empty());
+  ASSERT_EQ(v.back(), 2);
+  ASSERT_EQ(std::as_const(v).back(), 2);
+}
+
+TEST(vector, default_init_resize) {
+  vector::Vector<double> v(4, 1.0);
+  v.resize(1000, vector::kDefaultInit);
+  ASSERT_EQ(v.size(), 1000);
+  ASSERT_TRUE(std::all_of(v.cbegin(), v.cbegin() + 4,
+                          [](double x) { return x == 1.0; }));
+
+  // non-trivial elements are still constructed
+  vector::Vector<std::string> s(2, vector::kDefaultInit);
+  ASSERT_TRUE(s[0].empty() && s[1].empty());
+}
+
+TEST(vector, append) {
+  vector::Vector<int> v{1, 2};
+  std::vector<int> tail(100);
+  std::iota(tail.begin(), tail.end(), 3);
+  v.append(tail.data(), tail.data() + tail.size());
+  ASSERT_EQ(v.size(), 102);
+  ASSERT_EQ(v.back(), 102);
+
+  std::list<int> l{7, 8};
+  v.append(l.begin(), l.end());
+  ASSERT_EQ(v.back(), 8);
+
+  std::istringstream is("9 10 11");
+  v.append(std::istream_iterator<int>(is), std::istream_iterator<int>());
+  ASSERT_EQ(v.size(), 107);
+  ASSERT_EQ(v.back(), 11);
+}
+
+TEST(vector, push_back_own_element) {
+  vector::Vector<std::string> v(1, std::string(100, 'x'));
+  for (int i = 0; i < 100; ++i) {
+    v.push_back(v[0]);
+  }
+  ASSERT_TRUE(std::all_of(v.cbegin(), v.cend(),
+                          [](const auto& s) { return s.size() == 100; }));
+
+  vector::Vector<double> d(1, 3.0);
+  for (int i = 0; i < 100; ++i) {
+    d.push_back(d.back());
+  }
+  ASSERT_EQ(d.back(), 3.0);
+}
+
+TEST(vector, non_trivial_copy_and_reserve) {
+  vector::Vector<std::string> v;
+  for (int i = 0; i < 50; ++i) {
+    v.push_back(std::to_string(i));
+  }
+  auto copy = v;
+  copy.reserve(1000);
+  ASSERT_EQ(copy.size(), 50);
+  ASSERT_TRUE(std::equal(v.cbegin(), v.cend(), copy.cbegin()));
+}
+
+TEST(small_vector, inline_storage) {
+  AllocStats stats;
+  CountingAllocator<int> alloc(&stats);
+  {
+    vector::SmallVector<int, 4, CountingAllocator<int>> v(alloc);
+    for (int i = 0; i < 4; ++i) {
+      v.push_back(i);
+    }
+    ASSERT_EQ(stats.allocated, 0);
+    auto copy = v;
+    ASSERT_EQ(stats.allocated, 0);
+    ASSERT_TRUE(std::equal(v.cbegin(), v.cend(), copy.cbegin()));
+
+    v.push_back(4);
+    ASSERT_GT(stats.allocated, 0);
+    ASSERT_EQ(v.back(), 4);
+    ASSERT_EQ(v[2], 2);
+  }
+  ASSERT_EQ(stats.allocated, stats.deallocated);
+}
+
+TEST(small_vector, move_and_swap) {
+  using Small = vector::SmallVector<std::string, 2>;
+  Small a{"a", "b"};
+  Small b{"c", "d", "e"};
+  const auto* heap = b.data();
+
+  a.swap(b);
+  ASSERT_EQ(a.size(), 3);
+  ASSERT_EQ(a.data(), heap);
+  ASSERT_EQ(b.size(), 2);
+  ASSERT_EQ(b[1], "b");
+
+  swap(a, b);
+  ASSERT_EQ(a[0], "a");
+  ASSERT_EQ(b[2], "e");
+
+  Small moved(std::move(a));
+  ASSERT_EQ(moved[1], "b");
+  ASSERT_TRUE(a.empty());
+
+  moved = std::move(b);
+  ASSERT_EQ(moved.size(), 3);
+  ASSERT_EQ(moved.data(), heap);
+  ASSERT_TRUE(b.empty());
+  b.push_back("f");
+  ASSERT_EQ(b.back(), "f");
+}
+
+TEST(stats, allocations) {
+  vector::stats::reset();
+  {
+    vector::Vector<double> v(100);
+    v.reserve(1000);
+    vector::SmallVector<int, 4> small{1, 2};
+    vector::stats::ScopedPhase phase(vector::stats::Phase::kParse);
+  }
+
+  auto s = vector::stats::snapshot();
+  if constexpr (vector::stats::kEnabled) {
+    ASSERT_EQ(s.allocations, 2);
+    ASSERT_EQ(s.bytes_allocated, 1100 * sizeof(double));
+    ASSERT_EQ(s.reallocations, 1);
+    ASSERT_GT(s.phaseSeconds(vector::stats::Phase::kParse), 0);
+  } else {
+    ASSERT_EQ(s.allocations, 0);
+    ASSERT_EQ(s.phaseSeconds(vector::stats::Phase::kParse), 0);
+  }
+}
+
 int main(int argc, char** argv) {
   ::testing::InitGoogleTest(&argc, argv);
   return RUN_ALL_TESTS();
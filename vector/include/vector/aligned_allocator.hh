@@ -0,0 +1,59 @@
+/**
+ * Allocator returning memory aligned to a given boundary.
+ */
+#pragma once
+
+#include <cstddef>
+#include <limits>
+#include <new>
+
+namespace vector {
+
+constexpr std::size_t kCacheLineSize = 64;
+
+/**
+ * Stateless allocator with alignment suitable for aligned SIMD loads
+ * (default is a cache line, which is enough for AVX-512).
+ */
+template <typename T, std::size_t Align = kCacheLineSize>
+struct AlignedAllocator {
+  static_assert((Align & (Align - 1)) == 0, "Align must be a power of 2");
+  static_assert(Align >= alignof(T), "Align is weaker than alignof(T)");
+
+  using value_type = T;
+  static constexpr std::size_t kAlignment = Align;
+
+  template <typename U>
+  struct rebind {
+    using other = AlignedAllocator<U, Align>;
+  };
+
+  AlignedAllocator() noexcept = default;
+
+  template <typename U>
+  AlignedAllocator(const AlignedAllocator<U, Align>&) noexcept {}
+
+  T* allocate(std::size_t n) {
+    if (n > std::numeric_limits<std::size_t>::max() / sizeof(T)) {
+      throw std::bad_array_new_length();
+    }
+    return static_cast<T*>(
+        ::operator new(n * sizeof(T), std::align_val_t(Align)));
+  }
+
+  void deallocate(T* p, std::size_t) noexcept {
+    ::operator delete(p, std::align_val_t(Align));
+  }
+
+  template <typename U>
+  bool operator==(const AlignedAllocator<U, Align>&) const noexcept {
+    return true;
+  }
+
+  template <typename U>
+  bool operator!=(const AlignedAllocator<U, Align>&) const noexcept {
+    return false;
+  }
+};
+
+}  // namespace vector
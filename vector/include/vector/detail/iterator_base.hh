@@ -2,6 +2,7 @@
 
 #include <cstddef>
 #include <iterator>
+#include <type_traits>
 
 namespace vector::detail {
 
@@ -17,8 +18,15 @@ struct IteratorBase {
 
   explicit IteratorBase(pointer p) noexcept : ptr_(p) {};
 
-  reference operator*() noexcept { return *ptr_; }
-  pointer operator->() noexcept { return ptr_; }
+  // iterator is convertible to const_iterator
+  template <typename U = ValueType,
+            typename = std::enable_if_t<!std::is_const_v<U>>>
+  operator IteratorBase<const U>() const noexcept {
+    return IteratorBase<const U>(ptr_);
+  }
+
+  reference operator*() const noexcept { return *ptr_; }
+  pointer operator->() const noexcept { return ptr_; }
 
   // prefix increment
   IteratorBase& operator++() noexcept {
@@ -60,7 +68,9 @@ struct IteratorBase {
     return *this;
   }
 
-  reference operator[](difference_type pos) noexcept { return ptr_[pos]; }
+  reference operator[](difference_type pos) const noexcept {
+    return ptr_[pos];
+  }
 
   bool operator==(const IteratorBase& other) const noexcept {
     return ptr_ == other.ptr_;
@@ -5,67 +5,246 @@
 
 #include <algorithm>
 #include <cstddef>
+#include <cstring>
+#include <iterator>
 #include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#include "iterator_base.hh"
+#include "vector/stats.hh"
 
 /**
  * FOR INTERNAL PURPOSES ONLY. DO NOT USE IN USER PROGRAM
  */
 namespace vector::detail {
 
+template <typename Alloc, typename T, typename = void>
+struct HasConstruct : std::false_type {};
+
+template <typename Alloc, typename T>
+struct HasConstruct<Alloc, T,
+                    std::void_t<decltype(std::declval<Alloc&>().construct(
+                        std::declval<T*>(), std::declval<const T&>()))>>
+    : std::true_type {};
+
 /**
- * @defgroup Helper functions {
+ * Elements may be created and relocated by plain memory operations if
+ * they are trivially copyable and allocator does not customize
+ * construction (std::allocator::construct is placement new).
  */
-template <typename T, typename... Args>
-void construct(T* p, Args&&... args) {
-  new (p) T(std::forward<Args>(args)...);
-}
-
-template <typename T>
-void destroy(T* p) noexcept {
-  p->~T();
-}
-
-template <typename It,
-          typename = std::enable_if_t<std::is_base_of_v<
-              std::input_iterator_tag,
-              typename std::iterator_traits<It>::iterator_category>>>
-void destroy(It begin, It end) noexcept {
-  while (begin != end) {
-    destroy(std::addressof(*begin++));
-  }
-}
-/** } */
+template <typename T, typename Alloc>
+constexpr bool kBulkElems =
+    std::is_trivially_copyable_v<T> &&
+    (std::is_same_v<Alloc, std::allocator<T>> ||
+     !HasConstruct<Alloc, T>::value);
+
+/** Iterators over contiguous storage of T */
+template <typename It, typename T>
+constexpr bool kContiguousOf =
+    std::is_same_v<It, T*> || std::is_same_v<It, const T*> ||
+    std::is_same_v<It, IteratorBase<T>> ||
+    std::is_same_v<It, IteratorBase<const T>>;
+
+/** Alignment of memory returned by Alloc, if it declares one */
+template <typename Alloc, typename T, typename = void>
+struct AllocAlignment : std::integral_constant<std::size_t, alignof(T)> {};
+
+template <typename Alloc, typename T>
+struct AllocAlignment<Alloc, T, std::void_t<decltype(Alloc::kAlignment)>>
+    : std::integral_constant<std::size_t, Alloc::kAlignment> {};
+
+/**
+ * Raw storage for N elements inside of the object, aligned as memory
+ * from the allocator is.
+ */
+template <typename T, typename Alloc, std::size_t N>
+struct InlineStorage {
+  T* inlineData() noexcept { return reinterpret_cast<T*>(inline_); }
+
+  alignas(AllocAlignment<Alloc, T>::value) unsigned char inline_[N *
+                                                                 sizeof(T)];
+};
+
+template <typename T, typename Alloc>
+struct InlineStorage<T, Alloc, 0> {
+  T* inlineData() noexcept { return nullptr; }
+};
+
+/**
+ * Elements live in inline storage while they fit into N, on the heap
+ * otherwise. Without inline storage (N == 0) empty buffer holds nullptr.
+ */
+template <typename T, typename Alloc, std::size_t N = 0>
+struct VectorBuffer : InlineStorage<T, Alloc, N> {
+  using AllocTraits = std::allocator_traits<Alloc>;
+  static constexpr bool kBulk = kBulkElems<T, Alloc>;
+  static constexpr bool kNothrowMove =
+      N == 0 || std::is_nothrow_move_constructible_v<T>;
+
+  using InlineStorage<T, Alloc, N>::inlineData;
 
-template <typename T>
-struct VectorBuffer {
  public:  // state
+  Alloc alloc_;
   std::size_t sz_ = 0;
   std::size_t cap_;
   T* data_;
 
  public:  // constructors and destructor
-  explicit VectorBuffer(std::size_t cap)
-      : data_(cap ? static_cast<T*>(::operator new(cap * sizeof(T))) : nullptr),
-        cap_(cap) {}
+  explicit VectorBuffer(std::size_t cap, const Alloc& alloc = Alloc())
+      : alloc_(alloc),
+        cap_(cap <= N ? N : cap),
+        data_(cap <= N ? inlineData() : AllocTraits::allocate(alloc_, cap)) {
+    if (cap > N) {
+      stats::addAllocation(cap * sizeof(T));
+    }
+  }
 
   VectorBuffer(const VectorBuffer& other) = delete;
   VectorBuffer& operator=(const VectorBuffer& other) = delete;
 
-  VectorBuffer(VectorBuffer&& other) noexcept
-      : sz_(std::exchange(other.sz_, 0)),
-        cap_(std::exchange(other.cap_, 0)),
-        data_(std::exchange(other.data_, nullptr)) {}
+  VectorBuffer(VectorBuffer&& other) noexcept(kNothrowMove)
+      : alloc_(std::move(other.alloc_)), cap_(N), data_(inlineData()) {
+    stealFrom(other);
+  }
 
-  VectorBuffer& operator=(VectorBuffer&& other) noexcept {
-    sz_ = std::exchange(other.sz_, 0);
-    cap_ = std::exchange(other.cap_, 0);
-    data_ = std::exchange(other.data_, 0);
+  VectorBuffer& operator=(VectorBuffer&& other) noexcept(kNothrowMove) {
+    if (this != &other) {
+      release();
+      alloc_ = std::move(other.alloc_);
+      stealFrom(other);
+    }
     return *this;
   }
 
-  ~VectorBuffer() {
-    detail::destroy(data_, data_ + sz_);
-    ::operator delete(data_);
+  ~VectorBuffer() { release(); }
+
+ public:  // ownership
+  bool isInline() const noexcept {
+    return data_ == const_cast<VectorBuffer*>(this)->inlineData();
+  }
+
+  /** Destroys elements and returns to empty inline state */
+  void release() noexcept {
+    destroy(data_, data_ + sz_);
+    sz_ = 0;
+    if (!isInline()) {
+      AllocTraits::deallocate(alloc_, data_, cap_);
+      data_ = inlineData();
+      cap_ = N;
+    }
+  }
+
+  /**
+   * Takes elements of other, *this must be empty and inline.
+   * Heap memory changes owner, inline elements are moved one by one.
+   */
+  void stealFrom(VectorBuffer& other) noexcept(kNothrowMove) {
+    if (!other.isInline()) {
+      data_ = std::exchange(other.data_, other.inlineData());
+      cap_ = std::exchange(other.cap_, N);
+      sz_ = std::exchange(other.sz_, 0);
+      return;
+    }
+
+    for (; sz_ < other.sz_; ++sz_) {
+      construct(data_ + sz_, std::move(other.data_[sz_]));
+    }
+    other.release();
+  }
+
+  /** Replaces own storage with heap storage of other */
+  void adopt(VectorBuffer& other) noexcept {
+    release();
+    data_ = std::exchange(other.data_, other.inlineData());
+    cap_ = std::exchange(other.cap_, N);
+    sz_ = std::exchange(other.sz_, 0);
+  }
+
+ public:  // element management
+  template <typename... Args>
+  void construct(T* p, Args&&... args) {
+    AllocTraits::construct(alloc_, p, std::forward<Args>(args)...);
+  }
+
+  void destroy(T* p) noexcept { AllocTraits::destroy(alloc_, p); }
+
+  void destroy(T* begin, T* end) noexcept {
+    while (begin != end) {
+      destroy(begin++);
+    }
+  }
+
+  /**
+   * @defgroup Appending to the end, capacity must suffice. Size grows
+   * element by element, so constructed ones are destroyed on exception.
+   * {
+   */
+  void appendFill(std::size_t n, const T& val) {
+    if constexpr (kBulk) {
+      std::fill_n(data_ + sz_, n, val);
+      sz_ += n;
+    } else {
+      for (; n; --n, ++sz_) {
+        construct(data_ + sz_, val);
+      }
+    }
+  }
+
+  /** Leaves trivial elements uninitialized, value-initializes others */
+  void appendDefault(std::size_t n) {
+    if constexpr (kBulk && std::is_trivially_default_constructible_v<T>) {
+      sz_ += n;
+    } else {
+      for (; n; --n, ++sz_) {
+        construct(data_ + sz_);
+      }
+    }
+  }
+
+  template <typename It>
+  void appendCopy(It first, std::size_t n) {
+    if constexpr (kBulk && kContiguousOf<It, T>) {
+      if (n) {
+        std::memcpy(static_cast<void*>(data_ + sz_), &*first, n * sizeof(T));
+      }
+      sz_ += n;
+    } else {
+      for (; n; --n, ++sz_, ++first) {
+        construct(data_ + sz_, *first);
+      }
+    }
+  }
+
+  /**
+   * Moves elements of other into empty *this, leaving other with
+   * moved-from (or, for bulk types, bitwise copied) elements.
+   * Falls back to copying if moving may throw, to keep other intact.
+   */
+  void relocateFrom(VectorBuffer& other) {
+    if constexpr (kBulk) {
+      appendCopy(other.data_, other.sz_);
+    } else {
+      for (; sz_ < other.sz_; ++sz_) {
+        construct(data_ + sz_, std::move_if_noexcept(other.data_[sz_]));
+      }
+    }
+  }
+  /** } */
+
+  void swap(VectorBuffer& other) noexcept(kNothrowMove) {
+    if (isInline() || other.isInline()) {
+      VectorBuffer tmp(std::move(other));
+      other = std::move(*this);
+      *this = std::move(tmp);
+      return;
+    }
+
+    std::swap(alloc_, other.alloc_);
+    std::swap(sz_, other.sz_);
+    std::swap(cap_, other.cap_);
+    std::swap(data_, other.data_);
   }
 };
 
@@ -0,0 +1,169 @@
+/**
+ * Optional instrumentation of hot paths: time spent in phases of
+ * determinant computation, memory allocations and floating point work.
+ * Compiled in with MATRIX_ENABLE_STATS (cmake -DENABLE_STATS=ON),
+ * otherwise hooks are empty and optimized out.
+ */
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+namespace vector::stats {
+
+#ifdef MATRIX_ENABLE_STATS
+inline constexpr bool kEnabled = true;
+#else
+inline constexpr bool kEnabled = false;
+#endif
+
+enum class Phase {
+  kParse,        ///< reading input
+  kConvert,      ///< copying input into working storage of factorization
+  kPivotSearch,  ///< column scans, fused searches count as elimination
+  kRowSwap,
+  kElimination,  ///< row updates, triangular solves and trailing GEMM
+};
+
+inline constexpr std::size_t kNumPhases = 5;
+
+inline const char* phaseName(Phase phase) noexcept {
+  constexpr const char* kNames[kNumPhases] = {
+      "parse", "convert", "pivot_search", "row_swap", "elimination"};
+  return kNames[static_cast<std::size_t>(phase)];
+}
+
+/**
+ * Totals since start of the program or reset(). Phase times are summed
+ * over threads that were in the phase, work done by pool workers on
+ * behalf of a thread is counted once, as its wall time.
+ */
+struct Snapshot {
+  std::array<double, kNumPhases> seconds{};
+  std::uint64_t bytes_allocated = 0;
+  std::uint64_t allocations = 0;
+  std::uint64_t reallocations = 0;
+  double flops = 0;
+
+  double phaseSeconds(Phase phase) const noexcept {
+    return seconds[static_cast<std::size_t>(phase)];
+  }
+
+  /** Pivot search, row swaps and elimination */
+  double factorizationSeconds() const noexcept {
+    return phaseSeconds(Phase::kPivotSearch) +
+           phaseSeconds(Phase::kRowSwap) + phaseSeconds(Phase::kElimination);
+  }
+
+  double gflops() const noexcept {
+    auto seconds = factorizationSeconds();
+    return seconds > 0 ? flops / seconds * 1e-9 : 0;
+  }
+};
+
+/**
+ * FOR INTERNAL PURPOSES ONLY. DO NOT USE IN USER PROGRAM
+ */
+namespace detail {
+
+struct Counters {
+  std::array<std::atomic<std::uint64_t>, kNumPhases> nanoseconds{};
+  std::atomic<std::uint64_t> bytes_allocated{0};
+  std::atomic<std::uint64_t> allocations{0};
+  std::atomic<std::uint64_t> reallocations{0};
+  std::atomic<std::uint64_t> flops{0};
+};
+
+inline Counters& counters() noexcept {
+  static Counters counters;
+  return counters;
+}
+
+inline void add(std::atomic<std::uint64_t>& counter,
+                std::uint64_t value) noexcept {
+  counter.fetch_add(value, std::memory_order_relaxed);
+}
+
+}  // namespace detail
+
+/**
+ * @defgroup Hooks, no-ops unless kEnabled {
+ */
+inline void addAllocation(std::size_t bytes) noexcept {
+  if constexpr (kEnabled) {
+    detail::add(detail::counters().bytes_allocated, bytes);
+    detail::add(detail::counters().allocations, 1);
+  }
+}
+
+inline void addReallocation() noexcept {
+  if constexpr (kEnabled) {
+    detail::add(detail::counters().reallocations, 1);
+  }
+}
+
+inline void addFlops(double flops) noexcept {
+  if constexpr (kEnabled) {
+    detail::add(detail::counters().flops, static_cast<std::uint64_t>(flops));
+  }
+}
+
+/** Adds lifetime of the object to the phase */
+class ScopedPhase final {
+  using Clock = std::chrono::steady_clock;
+
+ public:
+  explicit ScopedPhase(Phase phase) noexcept : phase_(phase) {
+    if constexpr (kEnabled) {
+      start_ = Clock::now();
+    }
+  }
+
+  ScopedPhase(const ScopedPhase&) = delete;
+  ScopedPhase& operator=(const ScopedPhase&) = delete;
+
+  ~ScopedPhase() {
+    if constexpr (kEnabled) {
+      auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    Clock::now() - start_)
+                    .count();
+      detail::add(
+          detail::counters().nanoseconds[static_cast<std::size_t>(phase_)],
+          static_cast<std::uint64_t>(ns));
+    }
+  }
+
+ private:
+  Phase phase_;
+  Clock::time_point start_;
+};
+/** } */
+
+inline Snapshot snapshot() noexcept {
+  Snapshot res;
+  auto& c = detail::counters();
+  for (std::size_t i = 0; i < kNumPhases; ++i) {
+    res.seconds[i] = c.nanoseconds[i].load(std::memory_order_relaxed) * 1e-9;
+  }
+  res.bytes_allocated = c.bytes_allocated.load(std::memory_order_relaxed);
+  res.allocations = c.allocations.load(std::memory_order_relaxed);
+  res.reallocations = c.reallocations.load(std::memory_order_relaxed);
+  res.flops = static_cast<double>(c.flops.load(std::memory_order_relaxed));
+  return res;
+}
+
+inline void reset() noexcept {
+  auto& c = detail::counters();
+  for (auto& ns : c.nanoseconds) {
+    ns.store(0, std::memory_order_relaxed);
+  }
+  c.bytes_allocated.store(0, std::memory_order_relaxed);
+  c.allocations.store(0, std::memory_order_relaxed);
+  c.reallocations.store(0, std::memory_order_relaxed);
+  c.flops.store(0, std::memory_order_relaxed);
+}
+
+}  // namespace vector::stats
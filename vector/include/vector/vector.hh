@@ -4,19 +4,38 @@
  */
 #pragma once
 
+#include <algorithm>
 #include <initializer_list>
+#include <iterator>
+#include <memory>
+#include <type_traits>
 #include <utility>
 
 #include "detail/iterator_base.hh"
 #include "detail/vector_buffer.hh"
+#include "stats.hh"
 
 namespace vector {
 
+/** Tag requesting default-initialization, i.e. none for trivial types */
+struct DefaultInit {
+  explicit DefaultInit() = default;
+};
+
+inline constexpr DefaultInit kDefaultInit{};
+
 /**
  * Custom std::vector.
+ * Trivially copyable elements are filled, copied and relocated in bulk
+ * (memcpy) instead of element by element.
+ * Memory is obtained through std::allocator_traits<Alloc>, up to N elements
+ * are stored inline instead (see SmallVector).
  */
-template <typename T>
-class Vector final : private detail::VectorBuffer<T> {
+template <typename T, typename Alloc = std::allocator<T>, std::size_t N = 0>
+class Vector final : private detail::VectorBuffer<T, Alloc, N> {
+  using Buffer = detail::VectorBuffer<T, Alloc, N>;
+  using AllocTraits = std::allocator_traits<Alloc>;
+
  public:  // member types
   /**
    * @defgroup Iterators {
@@ -42,39 +61,56 @@ class Vector final : private detail::VectorBuffer<T> {
   using size_type = std::size_t;
   using const_reference = const value_type&;
   using const_pointer = const value_type*;
+  using allocator_type = Alloc;
   /** } */
 
  public:  // constructors
-  explicit Vector(size_type sz = 0, const_reference val = value_type())
-      : detail::VectorBuffer<value_type>(sz) {
-    std::fill_n(std::back_inserter(*this), sz, val);
+  Vector() noexcept(noexcept(Alloc())) : Buffer(0) {}
+
+  explicit Vector(const Alloc& alloc) noexcept : Buffer(0, alloc) {}
+
+  explicit Vector(size_type sz, const_reference val = value_type(),
+                  const Alloc& alloc = Alloc())
+      : Buffer(sz, alloc) {
+    Buffer::appendFill(sz, val);
+  }
+
+  /** Elements of trivial types are left uninitialized */
+  Vector(size_type sz, DefaultInit, const Alloc& alloc = Alloc())
+      : Buffer(sz, alloc) {
+    Buffer::appendDefault(sz);
   }
 
   template <typename It,
             typename = std::enable_if_t<std::is_base_of_v<
                 std::input_iterator_tag,
                 typename std::iterator_traits<It>::iterator_category>>>
-  Vector(It begin, It end)
-      : detail::VectorBuffer<value_type>(std::distance(begin, end)) {
-    std::copy(begin, end, std::back_inserter(*this));
+  Vector(It begin, It end, const Alloc& alloc = Alloc())
+      : Buffer(0, alloc) {
+    append(begin, end);
   }
 
-  Vector(std::initializer_list<value_type> ilist)
-      : Vector(ilist.begin(), ilist.end()) {}
+  Vector(std::initializer_list<value_type> ilist, const Alloc& alloc = Alloc())
+      : Vector(ilist.begin(), ilist.end(), alloc) {}
 
-  Vector(Vector&& rhs) noexcept = default;
-  Vector& operator=(Vector&& rhs) noexcept = default;
+  // noexcept unless inline elements may throw on move
+  Vector(Vector&& rhs) = default;
+  Vector& operator=(Vector&& rhs) = default;
 
-  Vector(const Vector& rhs) : detail::VectorBuffer<value_type>(rhs.sz_) {
-    std::copy(rhs.cbegin(), rhs.cend(), std::back_inserter(*this));
+  Vector(const Vector& rhs)
+      : Buffer(rhs.sz_,
+               AllocTraits::select_on_container_copy_construction(rhs.alloc_)) {
+    Buffer::appendCopy(rhs.data_, rhs.sz_);
   }
 
   Vector& operator=(const Vector& rhs) {
     Vector tmp(rhs);
-    std::swap(*this, tmp);
+    swap(tmp);
     return *this;
   }
 
+  allocator_type get_allocator() const noexcept { return alloc_; }
+
  public:  // iterators
   iterator begin() noexcept { return iterator(data_); }
   iterator end() noexcept { return iterator(data_ + sz_); }
@@ -96,36 +132,27 @@ class Vector final : private detail::VectorBuffer<T> {
       return;
     }
 
-    detail::VectorBuffer<value_type> new_buf(new_cap);
-    while (new_buf.sz_ < sz_) {
-      // to guarantee exception safety
-      if constexpr (std::is_nothrow_move_constructible_v<value_type>) {
-        detail::construct(new_buf.data_ + new_buf.sz_,
-                          std::move(data_[new_buf.sz_]));
-      } else {
-        detail::construct(new_buf.data_ + new_buf.sz_, data_[new_buf.sz_]);
-      }
-      ++new_buf.sz_;
+    if (sz_) {
+      stats::addReallocation();
     }
-
-    // reserve does NOT change the size of the vector
-    std::swap(new_buf.cap_, cap_);
-    std::swap(new_buf.data_, data_);
+    Buffer new_buf(new_cap, alloc_);
+    new_buf.relocateFrom(*this);
+    Buffer::adopt(new_buf);
   }
 
   size_type size() const noexcept { return sz_; }
   size_type capacity() const noexcept { return cap_; }
 
-  bool empty() const noexcept { return sz_; }
+  bool empty() const noexcept { return !sz_; }
 
  public:  // accessors
   pointer data() noexcept { return data_; }
   const_pointer data() const noexcept { return data_; }
 
   reference front() noexcept { return *begin(); };
-  reference back() noexcept { return *end(); }
+  reference back() noexcept { return data_[sz_ - 1]; }
   const_reference front() const noexcept { return *cbegin(); }
-  const_reference back() const noexcept { return *cend(); }
+  const_reference back() const noexcept { return data_[sz_ - 1]; }
 
   reference operator[](size_type pos) noexcept { return data_[pos]; }
   const_reference operator[](size_type pos) const noexcept {
@@ -135,44 +162,110 @@ class Vector final : private detail::VectorBuffer<T> {
  public:  // modifiers
   void resize(size_type new_sz, const value_type& v = value_type()) {
     if (new_sz <= sz_) {
-      detail::destroy(data_ + new_sz, data_ + sz_);
+      destroy(data_ + new_sz, data_ + sz_);
+      sz_ = new_sz;
+      return;
+    }
+
+    reserve(new_sz);
+    Buffer::appendFill(new_sz - sz_, v);
+  }
+
+  /** New elements of trivial types are left uninitialized */
+  void resize(size_type new_sz, DefaultInit) {
+    if (new_sz <= sz_) {
+      destroy(data_ + new_sz, data_ + sz_);
       sz_ = new_sz;
       return;
     }
 
     reserve(new_sz);
-    std::fill_n(std::back_inserter(*this), new_sz - sz_, v);
+    Buffer::appendDefault(new_sz - sz_);
+  }
+
+  /** Appends [begin, end), reallocating at most once for forward ranges */
+  template <typename It,
+            typename = std::enable_if_t<std::is_base_of_v<
+                std::input_iterator_tag,
+                typename std::iterator_traits<It>::iterator_category>>>
+  void append(It begin, It end) {
+    using Category = typename std::iterator_traits<It>::iterator_category;
+    if constexpr (std::is_base_of_v<std::forward_iterator_tag, Category>) {
+      auto n = static_cast<size_type>(std::distance(begin, end));
+      if (sz_ + n > cap_) {
+        reserve(std::max(sz_ + n, getNextCap(cap_)));
+      }
+      Buffer::appendCopy(begin, n);
+    } else {
+      for (; begin != end; ++begin) {
+        emplace_back(*begin);
+      }
+    }
   }
 
   template <typename... Args>
   void emplace_back(Args&&... args) {
-    if (sz_ == cap_) {
-      reserve(getNextCap(cap_));
+    if (sz_ != cap_) {
+      construct(data_ + sz_, std::forward<Args>(args)...);
+      ++sz_;
+      return;
+    }
+
+    // new element is created before relocation since args may refer
+    // to elements of this vector
+    Buffer new_buf(getNextCap(cap_), alloc_);
+    new_buf.construct(new_buf.data_ + sz_, std::forward<Args>(args)...);
+    try {
+      new_buf.relocateFrom(*this);
+    } catch (...) {
+      new_buf.destroy(new_buf.data_ + sz_);
+      throw;
     }
-    detail::construct(data_ + sz_, std::forward<Args>(args)...);
-    ++sz_;
+    ++new_buf.sz_;
+    Buffer::adopt(new_buf);
   }
 
-  void push_back(value_type&& v) { emplace_back(v); }
+  void push_back(value_type&& v) { emplace_back(std::move(v)); }
   void push_back(const_reference v) { emplace_back(v); }
 
   void clear() noexcept {
-    detail::destroy(begin(), end());
+    destroy(data_, data_ + sz_);
     sz_ = 0;
   }
 
   void pop_back() noexcept {
     --sz_;
-    detail::destroy(data_ + sz_);
+    destroy(data_ + sz_);
+  }
+
+  void swap(Vector& other) noexcept(Buffer::kNothrowMove) {
+    Buffer::swap(other);
   }
 
  private:
   static size_type getNextCap(size_type cap) noexcept { return (cap << 1) + 1; }
 
  private:
-  using detail::VectorBuffer<T>::sz_;
-  using detail::VectorBuffer<T>::cap_;
-  using detail::VectorBuffer<T>::data_;
+  using Buffer::alloc_;
+  using Buffer::cap_;
+  using Buffer::construct;
+  using Buffer::data_;
+  using Buffer::destroy;
+  using Buffer::sz_;
 };
 
+template <typename T, typename Alloc, std::size_t N>
+void swap(Vector<T, Alloc, N>& lhs,
+          Vector<T, Alloc, N>& rhs) noexcept(noexcept(lhs.swap(rhs))) {
+  lhs.swap(rhs);
+}
+
+/**
+ * Vector keeping up to N elements inside of the object, without
+ * allocations. Unlike heap storage, inline elements are moved one by one
+ * when vector is moved, so pointers to them are invalidated.
+ */
+template <typename T, std::size_t N, typename Alloc = std::allocator<T>>
+using SmallVector = Vector<T, Alloc, N>;
+
 }  // namespace vector